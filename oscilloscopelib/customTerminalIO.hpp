@@ -16,8 +16,16 @@
     #include <fcntl.h>
 #endif
 
+#include <charconv>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
 #define ENDLINE        "\r\n"
 
+#define OUTPUT_BUFFER_SIZE 4096 //Size of the buffer every print goes through before being written to the terminal
+#define INPUT_BUFFER_SIZE 64 //Starting size of the buffer get_str() reads into, it doubles whenever it gets full and it's kept between calls
+
 #define CTRL_KEY(in) ((in) & 0x1f)  //This code bitwise-ANDs the first 3 bits of "in" to 0 (being 0x1f = 00011111) to check if a key has been pressed alongside as CTRL
                                     //Got this line from https://viewsourcecode.org/snaptoken/kilo/03.rawInputAndOutput.html
 
@@ -176,6 +184,10 @@ namespace terminal{
         unsigned int print_precision = 6; //When printing a decimal number this integer determines the precision to use when printing it
 
         extern void printch(char input); //Used to print only a single character to the terminal and accepts only a single char input
+
+        //Everything printed is kept in a buffer and written with a single syscall when a newline gets printed, when the buffer is full, when input is read or when flush() is called
+        extern void flush(); //Writes whatever is still in the buffer to the terminal
+        bool unbuffered = false; //Set to true for every print to be written straight away, useful in raw mode when single characters need to show up as they're typed
         
         //Changes the color of the text written after this command is enabled, accepts either RGB input or normal predefined colors (written as preprocessor code at the start of this header)
         void set_color(int foreground, int background = BLACK, short rf = -1, short gf = -1, short bf = -1, short rb = -1, short gb = -1, short bb = -1){if(rf < 0 || gf < 0 || bf < 0 || rb < 0 || gb < 0 || bb < 0)terminal::out::print("\e[", foreground, ";", background + 10, "m"); else terminal::out::print("\e[38;2;", rf, ";", gf, ";", bf, "\e[48;2;", rb, ";", gb, ";", bb, "m");}
@@ -211,6 +223,75 @@ namespace terminal{
     //This namespace contains all internal functions which are only used in this header
     namespace internal{
         char *input;
+        unsigned long inputCapacity = 0;
+
+        bool reserveInput(unsigned long length){ //Makes input able to hold length characters keeping what it had, returns false if there's no memory left
+            if(length <= inputCapacity)return true;
+
+            unsigned long capacity = (inputCapacity < INPUT_BUFFER_SIZE ? INPUT_BUFFER_SIZE : inputCapacity * 2);
+            if(capacity < length)capacity = length;
+
+            char *buffer = new (std::nothrow) char[capacity];
+            if(buffer == nullptr)return false;
+
+            if(terminal::in::str_length > 0)memcpy(buffer, input, terminal::in::str_length);
+            delete[] input;
+
+            input = buffer;
+            inputCapacity = capacity;
+            return true;
+        }//terminal::internal::reserveInput();
+
+        //Namespace that contains the buffer all the output of the header goes through
+        namespace outputBuffer {
+            char buffer[OUTPUT_BUFFER_SIZE];
+            unsigned int used = 0; //Number of characters waiting in the buffer
+
+            void writeAll(const char *data, unsigned long length){ //Writes to the terminal directly, write() is allowed to only write part of the data
+                #if defined(_WIN32)
+                #elif defined(__linux__)
+                    while(length > 0){
+                        ssize_t written = ::write(STDOUT_FILENO, data, length);
+                        if(written <= 0)return;
+
+                        data += written;
+                        length -= written;
+                    }
+                #endif
+            }//terminal::internal::outputBuffer::writeAll();
+
+            void flush(){
+                if(used == 0)return;
+
+                writeAll(buffer, used);
+                used = 0;
+            }//terminal::internal::outputBuffer::flush();
+
+            void write(const char *data, unsigned long length){
+                if(terminal::out::unbuffered){
+                    flush(); //Anything buffered before unbuffered was turned on still has to come first
+                    writeAll(data, length);
+                    return;
+                }
+
+                if(used + length > OUTPUT_BUFFER_SIZE)flush(); //Not enough room left, making room for the new data
+
+                if(length > OUTPUT_BUFFER_SIZE){ //Data bigger than the whole buffer doesn't get copied at all
+                    writeAll(data, length);
+                    return;
+                }
+
+                memcpy(buffer + used, data, length);
+                used += length;
+
+                if(memchr(data, '\n', length) != nullptr)flush(); //A full line is ready to be shown
+            }//terminal::internal::outputBuffer::write();
+
+            //Whatever is left in the buffer when the program ends still gets written
+            struct flushAtExit {
+                ~flushAtExit(){flush();}
+            } flusher;
+        }//Namespace terminal::internal::outputBuffer;
 
         //Namespace used to manage terminal's rawmode
         namespace rawMode{
@@ -273,142 +354,84 @@ namespace terminal{
             }//terminal::internal::rawMode::enable();
         }//Namespace terminal::internal::rawMode;
 
-        //Function that executes a power (used in terminal::internal::convert namespace to convert a normal number to a string)
-        long double power(long base, long exponent){
-            long double output = 1; //Starts with the output as 1 (if the exponent is 0 then the output is 1)
-            if(exponent != 0) //If the exponent is not 0 execute the power, otherwise return the outpu which was set to 1
-            {
-                //Multiply the output by the base as many times as the absolute value of the exponent
-                if(exponent > 0)for(long i = 1;i <= exponent;i++)output *= base; 
-                else if(exponent < 0) for(long i = 1;i <= exponent * -1;i++)output *= base;
-
-                //If the exponent was negative return 1/output
-                return (exponent > 0 ? output : 1.000000000000000L / output);
-            } else return output;
-        }//terminal::internal::power();
-
-        //Namespace that contains all the 
+        //Namespace that contains the functions used to convert numbers to characters
         namespace convert {
-            //Function that returns a single digit of a long double
-            int returnSingleDigit(long double input, int digit){
-                if(input < 0)input *= -1; //Take the absolute value of the input
-
-                //If the digit is positive then return the asked digit for the decimal part, otherwise return the asked digit for the whole part
-                if(digit >= 0){
-                    for(int i = 0;i < digit;i++)input /= 10;
+            const unsigned int maxPrecision = 30; //print_precision gets capped to this so the length of a converted number is always bounded
+            const unsigned int maxNumberLength = 64; //Upper bound of the characters written by toCharArray(), sign, digits, decimal sign and exponent included
+
+            //Converts an integer writing its digits straight into output, no intermediate long double so every integer type is printed exactly
+            //Returns the number of characters written
+            template <typename integer, typename std::enable_if<std::is_integral<integer>::value, int>::type = 0>
+            unsigned int toCharArray(integer input, char *output){
+                if constexpr(std::is_same<integer, bool>::value){
+                    return toCharArray((int)input, output); //to_chars doesn't take bools, print them as 0 and 1
                 } else {
-                    for(int i = 0;i > digit;i--)input *= 10;
+                    std::to_chars_result result = std::to_chars(output, output + maxNumberLength, input);
+                    return result.ptr - output;
                 }
+            }//terminal::internal::convert::toCharArray();
 
-                return (int)(input - (unsigned long)(input / 10) * 10); //return the output rounded down
-            }//terminal::internal::convert::returnSingleDigit();
+            //Converts a decimal number in a single pass with up to print_precision decimals, trailing zeros are not printed and neither is the decimal sign if there are no decimals left
+            //Returns the number of characters written
+            template <typename decimal, typename std::enable_if<std::is_floating_point<decimal>::value, int>::type = 0>
+            unsigned int toCharArray(decimal input, char *output){
+                const unsigned int precision = (terminal::out::print_precision < maxPrecision ? terminal::out::print_precision : maxPrecision);
 
-            //Function used to get the number of digits of a long double input
-            int numberOfDigits(long double input){
-                unsigned int nOfDigits; //used to store the number of whole digits
-                unsigned int nOfDecimals; //used to store the number of decimal digits
-                unsigned int nOfTotalDigits; //The sum of the two previous variables
+                //Numbers too big to be written with all their whole digits within maxNumberLength get written in scientific notation
+                const bool scientific = (input >= (decimal)1e18 || input <= (decimal)-1e18);
 
-                long double absInput = (input < 0 ? input * -1 : input); //Store the absolute value of the input (invert the input if it's less than 0)
+                std::to_chars_result result = std::to_chars(output, output + maxNumberLength, input, scientific ? std::chars_format::scientific : std::chars_format::fixed, precision);
+                char *end = result.ptr;
 
-                for(nOfDigits = 1;true;nOfDigits++){
-                    if(absInput < (absInput >= 0 ? terminal::internal::power(10, nOfDigits) : terminal::internal::power(10, nOfDigits) * -1))break;
+                if(!scientific && precision > 0 && memchr(output, '.', end - output) != nullptr){
+                    while(*(end - 1) == '0')end--; //Removing the trailing zeros
+                    if(*(end - 1) == '.')end--;    //and the decimal sign if no decimals are left
                 }
-                if(input < 0)nOfDigits++;
-
-                nOfTotalDigits = nOfDigits;
-                        
-                if((long double)input > (long)input && (long double)input < (long)input + 1 || (long double)input < (long)input && (long double)input > (long)input - 1){
-                    nOfDecimals = terminal::out::print_precision;
 
-                    for(int i = terminal::out::print_precision + 1;i > 0;i--){
-                        if(returnSingleDigit(input, (i - 1) * -1) == 0)nOfDecimals--;
-                        else break;
-                    }
-
-                    nOfTotalDigits += ++nOfDecimals;
+                if(end - output == 2 && output[0] == '-' && output[1] == '0'){ //Something like -0.0000001 rounds to -0, print 0 instead
+                    output[0] = '0';
+                    end = output + 1;
                 }
 
-                return nOfTotalDigits;
-            }//terminal::internal::convert::numberOfDigits();
-
-            void toCharArray(long double input, char *output, unsigned int output_length){
-                const char negativeSign = '-';
-                const char decimalSign = '.';
-
-                unsigned int nOfDigits;
-                unsigned int nOfDecimals;
-                unsigned int nOfTotalDigits;
-                
-                bool negative = false;
-                bool decimal = false;
-
-                if(input < 0)negative=true;
-                for(nOfDigits = 1;true;nOfDigits++)if((negative ? input * -1 : input) < ((negative ? input * -1 : input) >= 0 ? terminal::internal::power(10, nOfDigits) : terminal::internal::power(10, nOfDigits) * -1))break;
-                if(negative)nOfDigits++;
-
-                nOfTotalDigits = nOfDigits;
-                
-                if((long double)input > (long)input && (long double)input < (long)input + 1 || (long double)input < (long)input && (long double)input > (long)input - 1){        
-                    nOfDecimals = terminal::out::print_precision;
-                    decimal = true;
-
-                    for(int i = terminal::out::print_precision + 1;i > 0;i--){
-                        if(returnSingleDigit(input, (i - 1) * -1) == 0)nOfDecimals--;
-                        else break;
-                    }
-
-                    nOfTotalDigits += nOfDecimals + 1;
-                }
-
-                char converted[nOfTotalDigits];
-
-                if(negative)converted[0] = negativeSign;
-                for(int i = (unsigned int)negative;i < nOfDigits;i++)converted[i] = (char)returnSingleDigit(input, nOfDigits - i - 1) + 48;
-
-                if(decimal){
-                    converted[nOfDigits] = decimalSign;
-                    for(int i = 1;i <= nOfDecimals;i++)converted[nOfDigits + i] = returnSingleDigit(input, i * -1) + 48;
-                }
+                return end - output;
+            }//terminal::internal::convert::toCharArray();
 
-                for(int i = 0;i <= nOfTotalDigits && i < output_length;i++)*(output + i) = converted[i];
-
-                return;
-            }
+            //Enumerations get printed as their underlying integer
+            template <typename enumeration, typename std::enable_if<std::is_enum<enumeration>::value, int>::type = 0>
+            unsigned int toCharArray(enumeration input, char *output){
+                return toCharArray((typename std::underlying_type<enumeration>::type)input, output);
+            }//terminal::internal::convert::toCharArray();
         }//Namespace terminal::internal::convert;
 
+        //Namespace that contains the functions used by print() and println() to join all their arguments into a single array
         namespace concat {
-            int sumAllLength(const char input[]){
-                int inputLength;
-                for(inputLength = 0;input[inputLength] != '\0';inputLength++);
-                return inputLength;
+            //Upper bound of the characters an argument will need, used to size the output array before anything gets converted
+            unsigned int sumAllLength(const char input[]){
+                return strlen(input);
             }
 
-            int sumAllLength(long double input){
-                return terminal::internal::convert::numberOfDigits(input);
+            template <typename number, typename std::enable_if<std::is_arithmetic<number>::value || std::is_enum<number>::value, int>::type = 0>
+            unsigned int sumAllLength(number input){
+                (void)input;
+                return terminal::internal::convert::maxNumberLength;
             }
 
-            void sumAll(const char input[], char *output, bool onlyChar = false){
-                int start;
-                for(start = 0;true;start++)if(*(output + start) == 0)break;
+            //Appends an argument at output and moves output after it, so every argument is converted only once and nothing is ever searched for
+            void sumAll(const char input[], char *&output, bool onlyChar = false){
+                (void)onlyChar;
 
-                for(int i = 0;input[i] != '\0';i++)*(output + start + i) = input[i];
+                unsigned int length = strlen(input);
+                memcpy(output, input, length);
+                output += length;
 
                 return;
             }
 
-            void sumAll(long double input, char *output, bool onlyChar = false){
-                if(onlyChar)return;
-
-                int char_length = terminal::internal::convert::numberOfDigits(input);
-                char char_input[char_length];
-
-                terminal::internal::convert::toCharArray(input, char_input, char_length);
+            template <typename number, typename std::enable_if<std::is_arithmetic<number>::value || std::is_enum<number>::value, int>::type = 0>
+            void sumAll(number input, char *&output, bool onlyChar = false){
+                if(onlyChar)return; //sprint() and sprintln() don't print numbers
 
-                int start;
-                for(start = 0;true;start++)if(*(output + start) == 0)break;
-
-                for(int i = 0;i < char_length;i++)*(output + start + i) = char_input[i];
+                output += terminal::internal::convert::toCharArray(input, output);
 
                 return;
             }
@@ -423,11 +446,7 @@ namespace file{
 }
 
 void terminal::in::get_str(bool echo, bool eSI, bool enterBreaks, char endChar, unsigned int maxLength){
-    bool outputN = false;
-
-    char* output1;
-    char* output0;
-
+    //The characters go straight into terminal::internal::input, it only grows when it's full so typing doesn't allocate at every key
     for(;;){
         char current_char = terminal::in::get_ch(true, echo, true, false, eSI);
 
@@ -438,8 +457,7 @@ void terminal::in::get_str(bool echo, bool eSI, bool enterBreaks, char endChar,
         if(current_char == 127){
             if(terminal::in::str_length < 1)continue;
 
-            if(outputN == 0)*(output0 + --terminal::in::str_length) = '\0'; 
-            else if(outputN == 1)*(output1 + --terminal::in::str_length) = '\0';
+            terminal::in::str_length--;
 
             terminal::cur::move_back();
             terminal::out::printch(' ');
@@ -447,44 +465,25 @@ void terminal::in::get_str(bool echo, bool eSI, bool enterBreaks, char endChar,
             continue;
         }
 
-        if(outputN == 1){
-            output1 = new char[++terminal::in::str_length];
-            outputN = !outputN;
-
-            for(unsigned int i = 0;i < terminal::in::str_length - 1;i++)*(output1 + i) = *(output0 + i);
-            *(output1 + terminal::in::str_length - 1) = current_char;
-
-            delete output0;
-        } else if(outputN == 0){
-            output0 = new char[++terminal::in::str_length];
-            outputN = !outputN;
-
-            for(unsigned int i = 0;i < terminal::in::str_length - 1;i++)*(output0 + i) = *(output1 + i);
-            *(output0 + terminal::in::str_length - 1) = current_char;
-
-            delete output1;
-        }
+        if(!terminal::internal::reserveInput(terminal::in::str_length + 1))break;
+        *(terminal::internal::input + terminal::in::str_length++) = current_char;
     }
 
-    delete terminal::internal::input;
-    terminal::internal::input = new char[terminal::in::str_length];
-
-    for(unsigned int i = 0;i < terminal::in::str_length;i++)*(terminal::internal::input + i) = (outputN ? *(output0 + i) : *(output1 + i));
-
     return;
 }
 
 void terminal::in::store_str(char* output){
-    for(int i = 0;i < terminal::in::str_length;i++)*(output + i) = *(terminal::internal::input + i);
+    if(terminal::in::str_length > 0)memcpy(output, terminal::internal::input, terminal::in::str_length);
     *(output + terminal::in::str_length) = '\0';
 
-    terminal::in::str_length = 0;
-    delete terminal::internal::input;
+    terminal::in::str_length = 0; //The buffer is kept for the next get_str()
 
     return;
 }
 
 char terminal::in::get_ch(bool waitForInput, bool echo, bool rawMode, bool eSC, bool eSI){
+    terminal::out::flush(); //Whatever was printed before asking for input has to be on the screen before we start waiting
+
     #if defined(_WIN32)
     #elif defined(__linux__)
         if(rawMode)terminal::internal::rawMode::enable(echo, eSI);
@@ -598,70 +597,62 @@ char terminal::in::get_ch(bool waitForInput, bool echo, bool rawMode, bool eSC,
 
 template <typename... args>
 void terminal::out::sprint(args... text){
-    int totSize = (sizeof(text) + ...); 
-    char totText[totSize];
-    for(int i = 0;i < totSize;i++)totText[i] = 0;
+    unsigned int totSize = (terminal::internal::concat::sumAllLength(text) + ... + 0);
+    char totText[totSize + 1];
+    char *end = totText; //Where the next argument gets written
 
     using expander = int[]; 
-    (void)expander{0, ((void)terminal::internal::concat::sumAll(text, totText, true), 0)...}; 
+    (void)expander{0, ((void)terminal::internal::concat::sumAll(text, end, true), 0)...}; 
 
-    #if defined(_WIN32)
-    #elif defined(__linux__)
-        write(STDOUT_FILENO, totText, totSize);
-    #endif
+    terminal::internal::outputBuffer::write(totText, end - totText);
 
     return;
 }
 
 template <typename... args>
 void terminal::out::sprintln(args... text){
-    int totSize = (sizeof(text) + ...); 
-    char totText[totSize];
-    for(int i = 0;i < totSize;i++)totText[i] = 0;
+    unsigned int totSize = (terminal::internal::concat::sumAllLength(text) + ... + 0);
+    char totText[totSize + 2];
+    char *end = totText; //Where the next argument gets written
 
     using expander = int[]; 
-    (void)expander{0, ((void)terminal::internal::concat::sumAll(text, totText, true), 0)...}; 
+    (void)expander{0, ((void)terminal::internal::concat::sumAll(text, end, true), 0)...}; 
 
-    #if defined(_WIN32)
-    #elif defined(__linux__)
-        write(STDOUT_FILENO, totText, totSize);
-        write(STDOUT_FILENO, ENDLINE, 2);
-    #endif
+    memcpy(end, ENDLINE, 2); //The ENDLINE goes in the same write as the rest of the line
+    end += 2;
+
+    terminal::internal::outputBuffer::write(totText, end - totText);
 
     return;
 }
 
 template <typename... args>
 void terminal::out::print(args... text){
-    int totSize = (terminal::internal::concat::sumAllLength(text) + ...); 
-    char totText[totSize];
-    for(int i = 0;i < totSize;i++)totText[i] = 0;
+    unsigned int totSize = (terminal::internal::concat::sumAllLength(text) + ... + 0); //Only an upper bound, the numbers get converted once while they're written
+    char totText[totSize + 1];
+    char *end = totText; //Where the next argument gets written
 
     using expander = int[]; 
-    (void)expander{0, ((void)terminal::internal::concat::sumAll(text, totText), 0)...};
+    (void)expander{0, ((void)terminal::internal::concat::sumAll(text, end), 0)...};
 
-    #if defined(_WIN32)
-    #elif defined(__linux__)
-        write(STDOUT_FILENO, totText, totSize);
-    #endif
+    terminal::internal::outputBuffer::write(totText, end - totText);
 
     return;
 }
 
 template <typename... args>
 void terminal::out::println(args... text){
-    int totSize = (terminal::internal::concat::sumAllLength(text) + ...);
-    char totText[totSize];
-    for(int i = 0;i < totSize;i++)totText[i] = 0;
+    unsigned int totSize = (terminal::internal::concat::sumAllLength(text) + ... + 0); //Only an upper bound, the numbers get converted once while they're written
+    char totText[totSize + 2];
+    char *end = totText; //Where the next argument gets written
 
     using expander = int[];
-    (void)expander{0, ((void)terminal::internal::concat::sumAll(text, totText), 0)...}; 
+    (void)expander{0, ((void)terminal::internal::concat::sumAll(text, end), 0)...}; 
 
-    #if defined(_WIN32)
-    #elif defined(__linux__)
-        write(STDOUT_FILENO, totText, totSize);
-        write(STDOUT_FILENO, ENDLINE, 2);
-    #endif
+    memcpy(end, ENDLINE, 2); //The ENDLINE goes in the same write as the rest of the line
+    end += 2;
+
+    terminal::internal::outputBuffer::write(totText, end - totText);
 
     return;
 }
@@ -670,10 +661,13 @@ void terminal::out::printch(char input){
     char output[1];
     output[0] = input;
 
-    #if defined(_WIN32)
-    #elif defined(__linux__)
-        write(STDOUT_FILENO, output, 1);
-    #endif
+    terminal::internal::outputBuffer::write(output, 1);
+
+    return;
+}
+
+void terminal::out::flush(){
+    terminal::internal::outputBuffer::flush();
 
     return;
 }
@@ -0,0 +1,100 @@
+#ifndef OSCFONT_HPP
+#define OSCFONT_HPP
+
+//Stroke font used by oscilloscopeLibrary::draw_text()
+//Every glyph sits on a grid 4 units wide and 6 units high with the origin on its bottom left corner, y goes up like on the oscilloscope
+//A glyph is a list of strokes separated by spaces, every stroke is a list of vertices connected by lines and every vertex is written as two digits: x then y
+//Only the characters from ' ' to '~' are defined, lowercase letters are drawn with the uppercase glyphs
+
+#define OSCFONT_FIRST_CHAR  ' '
+#define OSCFONT_LAST_CHAR   '~'
+#define OSCFONT_GLYPHS      (OSCFONT_LAST_CHAR - OSCFONT_FIRST_CHAR + 1)
+
+#define OSCFONT_WIDTH       4 //Size of the glyph grid
+#define OSCFONT_HEIGHT      6
+
+namespace osclib_font {
+    const char *glyphs[OSCFONT_GLYPHS] = {
+        "",                                     //' '
+        "2622 2120",                            //'!'
+        "1614 3634",                            //'"'
+        "1511 3531 0444 0242",                  //'#'
+        "450503434101 2620",                    //'$'
+        "0046 0616150506 3141403031",           //'%'
+        "400416262402002042",                   //'&'
+        "2624",                                 //'''
+        "36252130",                             //'('
+        "16252110",                             //')'
+        "1533 3513 0444",                       //'*'
+        "2125 0343",                            //'+'
+        "2110",                                 //','
+        "0343",                                 //'-'
+        "2021",                                 //'.'
+        "0046",                                 //'/'
+        "000646400046",                         //'0'
+        "152620 1030",                          //'1'
+        "064643030040",                         //'2'
+        "06464000 0343",                        //'3'
+        "060343 4640",                          //'4'
+        "460603434000",                         //'5'
+        "460600404303",                         //'6'
+        "064640",                               //'7'
+        "0006464000 0343",                      //'8'
+        "4046060343",                           //'9'
+        "2425 2122",                            //':'
+        "2425 2110",                            //';'
+        "350331",                               //'<'
+        "0242 0444",                            //'='
+        "154311",                               //'>'
+        "05163645442322 2120",                  //'?'
+        "32121434314146060040",                 //'@'
+        "0004264440 0343",                      //'A'
+        "00063645443342413000 0333",            //'B'
+        "46060040",                             //'C'
+        "00062644422000",                       //'D'
+        "46060040 0333",                        //'E'
+        "460600 0333",                          //'F'
+        "460600404323",                         //'G'
+        "0006 4640 0343",                       //'H'
+        "1636 2620 1030",                       //'I'
+        "46400002",                             //'J'
+        "0006 4602 1340",                       //'K'
+        "060040",                               //'L'
+        "0006234640",                           //'M'
+        "00064046",                             //'N'
+        "0006464000",                           //'O'
+        "0006464303",                           //'P'
+        "0006464000 2240",                      //'Q'
+        "0006464303 1340",                      //'R'
+        "460603434000",                         //'S'
+        "0646 2620",                            //'T'
+        "06004046",                             //'U'
+        "062046",                               //'V'
+        "0610233046",                           //'W'
+        "0046 0640",                            //'X'
+        "062346 2320",                          //'Y'
+        "06460040",                             //'Z'
+        "36161030",                             //'['
+        "0640",                                 //'\'
+        "16363010",                             //']'
+        "042644",                               //'^'
+        "0040",                                 //'_'
+        "1625",                                 //'`'
+        "", "", "", "", "", "", "", "", "", "", "", "", "", //'a' to 'm', drawn with the uppercase glyphs
+        "", "", "", "", "", "", "", "", "", "", "", "", "", //'n' to 'z'
+        "36252413222130",                       //'{'
+        "2620",                                 //'|'
+        "16252433222110",                       //'}'
+        "04153445"                              //'~'
+    };
+
+    //Returns the position in glyphs of a character's strokes, lowercase letters get the uppercase glyphs and characters outside the font get '?'
+    unsigned int glyphIndex(char character){
+        if(character >= 'a' && character <= 'z')character -= 'a' - 'A';
+        if(character < OSCFONT_FIRST_CHAR || character > OSCFONT_LAST_CHAR)character = '?';
+
+        return character - OSCFONT_FIRST_CHAR;
+    } //osclib_font::glyphIndex
+} //namespace osclib_font
+
+#endif
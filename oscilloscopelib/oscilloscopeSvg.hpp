@@ -0,0 +1,836 @@
+#ifndef OSCSVG_HPP
+#define OSCSVG_HPP
+
+#include "oscilloscopelib.hpp"
+
+//SVG importer for oscilloscopeLibrary
+//osclib_svg::load() reads an SVG file a block at a time and draws its <path>, <line>, <polyline>, <polygon>, <rect>, <circle> and <ellipse> elements
+//into a new scene object, with the transform attributes of the elements and of their groups, so only their outlines get drawn
+//The picture is fit into the 0 to 200 square keeping its proportions, the object can then be moved and transformed like any other scene object
+//The samples of the object get saved into a cache file together with a hash of the SVG, loading the same file again only reads the samples back
+
+#define SVG_READ_BLOCK (65536) //Bytes read from the file at a time
+#define SVG_ARC_SEGMENT (M_PI / 2.00) //Arcs get split into cubic beziers of at most this many radians, a bezier is very close to a quarter of a circle
+#define SVG_CACHE_MAGIC ("OSCSVG01") //First 8 bytes of a cache file, the number changes when the format does
+#define SVG_CACHE_EXTENSION (".osccache") //Added to the SVG's name for the default cache file
+#define SVG_CACHE_NEXT_TO_FILE ("") //cache_path value for the default cache file, nullptr turns the cache off
+
+namespace osclib_svg {
+    namespace internal {
+        typedef struct {
+            int file;
+            char block[SVG_READ_BLOCK];
+            size_t length;   //Bytes read into block
+            size_t position; //Next byte of block to look at
+
+            char *tag; //What's between the < and the > of the current tag, always ended by a 0
+            size_t tag_length;
+            size_t tag_capacity;
+        } tagReader;
+
+        //Hash of the whole file, 8 bytes at a time so hashing is a lot faster than parsing
+        //It's FNV-1a on 64-bit words instead of bytes, it only has to tell if the file changed
+        bool hashFile(const char *path, unsigned long long *hash){
+            int file = open(path, O_RDONLY);
+            if(file < 0)return false;
+
+            unsigned long long *words = new (std::nothrow) unsigned long long[SVG_READ_BLOCK / 8];
+            if(words == nullptr){
+                close(file);
+                return false;
+            }
+            unsigned long long value = 0xcbf29ce484222325ULL;
+            unsigned long long total = 0;
+
+            ssize_t bytes;
+            while((bytes = read(file, words, SVG_READ_BLOCK)) > 0){
+                const size_t count = (size_t)bytes / 8;
+                for(size_t i = 0; i < count; i++)value = (value ^ words[i]) * 0x100000001b3ULL;
+
+                const unsigned char *tail = (const unsigned char*)(words + count);
+                for(size_t i = count * 8; i < (size_t)bytes; i++)value = (value ^ *tail++) * 0x100000001b3ULL;
+
+                total += bytes;
+            }
+            close(file);
+            delete[] words;
+            if(bytes < 0)return false;
+
+            *hash = (value ^ total) * 0x100000001b3ULL; //Files that are the same except for trailing zeros get different hashes
+            return true;
+        } //osclib_svg::internal::hashFile
+
+        bool appendTag(tagReader &reader, char character){
+            if(reader.tag_length + 1 >= reader.tag_capacity){
+                const size_t capacity = (reader.tag_capacity < 256 ? 256 : reader.tag_capacity * 2);
+                char *tag = new (std::nothrow) char[capacity];
+                if(tag == nullptr)return false;
+
+                if(reader.tag_length > 0)memcpy(tag, reader.tag, reader.tag_length);
+                delete[] reader.tag;
+                reader.tag = tag;
+                reader.tag_capacity = capacity;
+            }
+
+            reader.tag[reader.tag_length++] = character;
+            reader.tag[reader.tag_length] = '\0';
+            return true;
+        } //osclib_svg::internal::appendTag
+
+        //Reads up to the end of the next tag, comments, declarations and processing instructions are skipped, false at the end of the file
+        bool nextTag(tagReader &reader, bool *failed){
+            for(;;){
+                bool inside = false;
+                char quote = 0;
+                reader.tag_length = 0;
+                if(reader.tag != nullptr)reader.tag[0] = '\0';
+
+                for(;;){
+                    if(reader.position == reader.length){
+                        ssize_t bytes = read(reader.file, reader.block, SVG_READ_BLOCK);
+                        if(bytes <= 0){
+                            *failed = (bytes < 0);
+                            return false;
+                        }
+                        reader.length = bytes;
+                        reader.position = 0;
+                    }
+
+                    const char character = reader.block[reader.position++];
+                    if(!inside){ //Text between the tags doesn't matter
+                        inside = (character == '<');
+                        continue;
+                    }
+
+                    //A > only ends the tag outside of the attribute values, and comments only end with -->
+                    if(character == '>' && quote == 0){
+                        const bool comment = (reader.tag_length >= 3 && strncmp(reader.tag, "!--", 3) == 0);
+                        if(!comment || (reader.tag_length >= 5 && strcmp(reader.tag + reader.tag_length - 2, "--") == 0))break;
+                    }
+
+                    if(reader.tag_length > 0 && reader.tag[0] != '!'){ //Quotes inside comments and declarations don't mean anything
+                        if(quote == 0 && (character == '"' || character == '\''))quote = character;
+                        else if(character == quote)quote = 0;
+                    }
+
+                    if(!appendTag(reader, character)){
+                        *failed = true;
+                        return false;
+                    }
+                }
+
+                if(reader.tag_length > 0 && reader.tag[0] != '!' && reader.tag[0] != '?')return true;
+            }
+        } //osclib_svg::internal::nextTag
+
+        bool isSpace(char character){
+            return character == ' ' || character == '\t' || character == '\n' || character == '\r';
+        } //osclib_svg::internal::isSpace
+
+        //Finds the value of an attribute of the current tag, value points right after the opening quote and length is how long it is
+        bool attribute(const char *tag, const char *name, const char **value, size_t *length){
+            const size_t name_length = strlen(name);
+            char quote = 0;
+
+            for(const char *cursor = tag; *cursor != '\0'; cursor++){
+                if(quote != 0){ //Skipping attribute values so a value containing the name doesn't match
+                    if(*cursor == quote)quote = 0;
+                    continue;
+                }
+                if(*cursor == '"' || *cursor == '\''){
+                    quote = *cursor;
+                    continue;
+                }
+
+                if(!isSpace(*cursor) || strncmp(cursor + 1, name, name_length) != 0)continue;
+
+                const char *equal = cursor + 1 + name_length;
+                while(isSpace(*equal))equal++;
+                if(*equal != '=')continue;
+
+                equal++;
+                while(isSpace(*equal))equal++;
+                if(*equal != '"' && *equal != '\'')continue;
+
+                const char *end = strchr(equal + 1, *equal);
+                if(end == nullptr)return false;
+
+                *value = equal + 1;
+                *length = end - *value;
+                return true;
+            }
+
+            return false;
+        } //osclib_svg::internal::attribute
+
+        //Reads a number skipping the spaces and the comma before it, SVG numbers can be packed like "10-5.5.5" (10, -5.5 and 0.5)
+        //Parsed by hand since strtof() depends on the locale and needs the text to end where the number does
+        bool number(const char *&cursor, const char *end, float *output){
+            while(cursor < end && (isSpace(*cursor) || *cursor == ','))cursor++;
+            if(cursor == end)return false;
+
+            const char *start = cursor;
+            double sign = 1.00;
+            if(*cursor == '+' || *cursor == '-'){
+                if(*cursor == '-')sign = -1.00;
+                cursor++;
+            }
+
+            double value = 0.00;
+            bool digits = false;
+            while(cursor < end && *cursor >= '0' && *cursor <= '9'){
+                value = value * 10.00 + (*cursor++ - '0');
+                digits = true;
+            }
+            if(cursor < end && *cursor == '.'){
+                cursor++;
+                double scale = 0.10;
+                while(cursor < end && *cursor >= '0' && *cursor <= '9'){
+                    value += (*cursor++ - '0') * scale;
+                    scale *= 0.10;
+                    digits = true;
+                }
+            }
+            if(!digits){
+                cursor = start;
+                return false;
+            }
+
+            if(cursor < end && (*cursor == 'e' || *cursor == 'E')){
+                const char *exponent_start = cursor++;
+                int exponent_sign = 1;
+                if(cursor < end && (*cursor == '+' || *cursor == '-')){
+                    if(*cursor == '-')exponent_sign = -1;
+                    cursor++;
+                }
+
+                int exponent = 0;
+                bool exponent_digits = false;
+                while(cursor < end && *cursor >= '0' && *cursor <= '9'){
+                    exponent = exponent * 10 + (*cursor++ - '0');
+                    exponent_digits = true;
+                }
+
+                if(exponent_digits)value *= std::pow(10.00, exponent_sign * exponent);
+                else cursor = exponent_start; //Not an exponent after all
+            }
+
+            *output = (float)(sign * value);
+            return true;
+        } //osclib_svg::internal::number
+
+        bool flag(const char *&cursor, const char *end, bool *output){ //Arc flags are a single 0 or 1 and can be written with nothing between them
+            while(cursor < end && (isSpace(*cursor) || *cursor == ','))cursor++;
+            if(cursor == end || (*cursor != '0' && *cursor != '1'))return false;
+
+            *output = (*cursor++ == '1');
+            return true;
+        } //osclib_svg::internal::flag
+
+        float numberAttribute(const char *tag, const char *name, float fallback){
+            const char *value;
+            size_t length;
+            float output;
+
+            if(!attribute(tag, name, &value, &length))return fallback;
+            return (number(value, value + length, &output) ? output : fallback);
+        } //osclib_svg::internal::numberAttribute
+
+        oscTransform multiply(const oscTransform &first, const oscTransform &second){ //The transform doing second and then first
+            return {
+                first.a * second.a + first.c * second.b,
+                first.b * second.a + first.d * second.b,
+                first.a * second.c + first.c * second.d,
+                first.b * second.c + first.d * second.d,
+                first.a * second.e + first.c * second.f + first.e,
+                first.b * second.e + first.d * second.f + first.f
+            };
+        } //osclib_svg::internal::multiply
+
+        //Applies the transform attribute of the current tag, if it has one, on top of matrix
+        void transformAttribute(const char *tag, oscTransform *matrix){
+            const char *value;
+            size_t length;
+            if(!attribute(tag, "transform", &value, &length))return;
+
+            const char *cursor = value;
+            const char *end = value + length;
+
+            while(cursor < end){
+                while(cursor < end && (isSpace(*cursor) || *cursor == ','))cursor++;
+
+                const char *name = cursor;
+                while(cursor < end && *cursor != '(')cursor++;
+                if(cursor == end)return;
+                cursor++;
+
+                float arguments[6];
+                unsigned int count = 0;
+                while(count < 6 && number(cursor, end, &arguments[count]))count++;
+                while(cursor < end && *cursor != ')')cursor++;
+                if(cursor < end)cursor++;
+
+                //Every transform of the list is in the coordinates left by the ones before it
+                oscTransform step = oscilloscopeLibrary::identity_transform();
+                if(strncmp(name, "matrix", 6) == 0 && count == 6)step = {arguments[0], arguments[1], arguments[2], arguments[3], arguments[4], arguments[5]};
+                else if(strncmp(name, "translate", 9) == 0 && count >= 1){
+                    step.e = arguments[0];
+                    step.f = (count >= 2 ? arguments[1] : 0.00f);
+                } else if(strncmp(name, "scale", 5) == 0 && count >= 1){
+                    step.a = arguments[0];
+                    step.d = (count >= 2 ? arguments[1] : arguments[0]);
+                } else if(strncmp(name, "rotate", 6) == 0 && count >= 1){
+                    const float angle = arguments[0] * M_PI / 180.00f;
+                    const float cosine = std::cos(angle), sine = std::sin(angle);
+                    const float cx = (count >= 3 ? arguments[1] : 0.00f), cy = (count >= 3 ? arguments[2] : 0.00f);
+                    step = {cosine, sine, -sine, cosine, cx - cosine * cx + sine * cy, cy - sine * cx - cosine * cy};
+                } else if(strncmp(name, "skewX", 5) == 0 && count >= 1)step.c = std::tan(arguments[0] * M_PI / 180.00f);
+                else if(strncmp(name, "skewY", 5) == 0 && count >= 1)step.b = std::tan(arguments[0] * M_PI / 180.00f);
+
+                *matrix = multiply(*matrix, step);
+            }
+        } //osclib_svg::internal::transformAttribute
+
+        //Vertices of the straight lines of a path, they get drawn as one polyline when a curve or a new subpath starts
+        typedef struct {
+            oscPointF *points;
+            unsigned int count;
+            unsigned int capacity;
+        } pointList;
+
+        bool addPoint(pointList &list, float x, float y){
+            if(list.count == list.capacity){
+                const unsigned int capacity = (list.capacity < 64 ? 64 : list.capacity * 2);
+                oscPointF *points = new (std::nothrow) oscPointF[capacity];
+                if(points == nullptr)return false;
+
+                if(list.count > 0)memcpy(points, list.points, list.count * sizeof(oscPointF));
+                delete[] list.points;
+                list.points = points;
+                list.capacity = capacity;
+            }
+
+            list.points[list.count++] = {x, y};
+            return true;
+        } //osclib_svg::internal::addPoint
+
+        osclib_err flushLines(oscilloscopeLibrary &oscilloscope, pointList &list, bool closed){ //Draws the lines collected so far and keeps the last point as the start of the next ones
+            osclib_err error_output = osc_no_err;
+            if(list.count >= 2)error_output = oscilloscope.draw_polylinef(list.points, list.count, closed);
+
+            if(list.count > 0){
+                list.points[0] = list.points[list.count - 1];
+                list.count = 1;
+            }
+            return error_output;
+        } //osclib_svg::internal::flushLines
+
+        //Elliptical arc from the current point to x y, converted to its center and angles (appendix F.6.5 of the SVG spec) and drawn as cubic beziers
+        osclib_err drawArc(oscilloscopeLibrary &oscilloscope, float x0, float y0, float rx, float ry, float rotation, bool large, bool sweep, float x, float y){
+            if(x0 == x && y0 == y)return osc_no_err;
+            rx = std::fabs(rx);
+            ry = std::fabs(ry);
+            if(rx == 0.00f || ry == 0.00f)return oscilloscope.draw_linef(x0, y0, x, y); //No radius, it's a straight line
+
+            const double angle = rotation * M_PI / 180.00;
+            const double cosine = std::cos(angle), sine = std::sin(angle);
+
+            //The middle of the chord in the coordinates of the ellipse
+            const double middleX = cosine * (x0 - x) / 2.00 + sine * (y0 - y) / 2.00;
+            const double middleY = -sine * (x0 - x) / 2.00 + cosine * (y0 - y) / 2.00;
+
+            //Radii too small to reach the end point get scaled up just enough
+            double radiusX = rx, radiusY = ry;
+            const double lambda = (middleX * middleX) / (radiusX * radiusX) + (middleY * middleY) / (radiusY * radiusY);
+            if(lambda > 1.00){
+                radiusX *= std::sqrt(lambda);
+                radiusY *= std::sqrt(lambda);
+            }
+
+            double factor = (radiusX * radiusX * radiusY * radiusY - radiusX * radiusX * middleY * middleY - radiusY * radiusY * middleX * middleX) /
+                            (radiusX * radiusX * middleY * middleY + radiusY * radiusY * middleX * middleX);
+            factor = std::sqrt(factor > 0.00 ? factor : 0.00) * (large == sweep ? -1.00 : 1.00);
+
+            const double centerX_ = factor * radiusX * middleY / radiusY;
+            const double centerY_ = -factor * radiusY * middleX / radiusX;
+            const double centerX = cosine * centerX_ - sine * centerY_ + (x0 + x) / 2.00;
+            const double centerY = sine * centerX_ + cosine * centerY_ + (y0 + y) / 2.00;
+
+            const double startAngle = std::atan2((middleY - centerY_) / radiusY, (middleX - centerX_) / radiusX);
+            double sweepAngle = std::atan2((-middleY - centerY_) / radiusY, (-middleX - centerX_) / radiusX) - startAngle;
+            if(sweep && sweepAngle < 0.00)sweepAngle += 2.00 * M_PI;
+            if(!sweep && sweepAngle > 0.00)sweepAngle -= 2.00 * M_PI;
+
+            //Every piece is a bezier with its control points on the tangents, k * radius away from the ends
+            const unsigned int pieces = (unsigned int)std::ceil(std::fabs(sweepAngle) / SVG_ARC_SEGMENT - 1e-6);
+            const double step = sweepAngle / pieces;
+            const double k = 4.00 / 3.00 * std::tan(step / 4.00);
+
+            auto pointAt = [&](double theta, double derivative, double *px, double *py){ //Point of the ellipse at theta, or its tangent if derivative is 1
+                const double ux = (derivative > 0.00 ? -std::sin(theta) : std::cos(theta)) * radiusX;
+                const double uy = (derivative > 0.00 ?  std::cos(theta) : std::sin(theta)) * radiusY;
+                *px = cosine * ux - sine * uy + (derivative > 0.00 ? 0.00 : centerX);
+                *py = sine * ux + cosine * uy + (derivative > 0.00 ? 0.00 : centerY);
+            };
+
+            double fromX = x0, fromY = y0;
+            for(unsigned int i = 0; i < pieces; i++){
+                const double theta1 = startAngle + step * i;
+                const double theta2 = theta1 + step;
+
+                double tangent1X, tangent1Y, tangent2X, tangent2Y, toX, toY;
+                pointAt(theta1, 1.00, &tangent1X, &tangent1Y);
+                pointAt(theta2, 1.00, &tangent2X, &tangent2Y);
+                pointAt(theta2, 0.00, &toX, &toY);
+                if(i + 1 == pieces){ //Ending exactly on the end point
+                    toX = x;
+                    toY = y;
+                }
+
+                osclib_err error_output = oscilloscope.draw_bezierf({(float)fromX, (float)fromY}, {(float)(fromX + k * tangent1X), (float)(fromY + k * tangent1Y)},
+                                                                    {(float)(toX - k * tangent2X), (float)(toY - k * tangent2Y)}, {(float)toX, (float)toY});
+                if(error_output != osc_no_err)return error_output;
+
+                fromX = toX;
+                fromY = toY;
+            }
+
+            return osc_no_err;
+        } //osclib_svg::internal::drawArc
+
+        //Draws the d attribute of a <path>, drawing stops at the first thing that doesn't make sense like the SVG spec asks
+        osclib_err drawPath(oscilloscopeLibrary &oscilloscope, const char *data, size_t length, pointList &lines){
+            const char *cursor = data;
+            const char *end = data + length;
+
+            float x = 0.00f, y = 0.00f; //Current point
+            float startX = 0.00f, startY = 0.00f; //Start of the subpath, Z goes back there
+            float controlX = 0.00f, controlY = 0.00f; //Last control point, S and T mirror it
+            char previous = 0;
+            char command = 0;
+            lines.count = 0;
+
+            osclib_err error_output = osc_no_err;
+            while(error_output == osc_no_err){
+                while(cursor < end && (isSpace(*cursor) || *cursor == ','))cursor++;
+                if(cursor == end)break;
+
+                if((*cursor >= 'A' && *cursor <= 'Z') || (*cursor >= 'a' && *cursor <= 'z'))command = *cursor++;
+                else if(command == 0)break; //Numbers before the first command
+                else if(command == 'M')command = 'L'; //Pairs after a moveto are linetos
+                else if(command == 'm')command = 'l';
+
+                const bool relative = (command >= 'a' && command <= 'z');
+                const float baseX = (relative ? x : 0.00f), baseY = (relative ? y : 0.00f);
+                const char upper = (relative ? command - ('a' - 'A') : command);
+
+                float v[7];
+                bool f[2];
+                bool ok = true;
+
+                switch(upper){
+                    case 'M':
+                        ok = number(cursor, end, &v[0]) && number(cursor, end, &v[1]);
+                        if(!ok)break;
+
+                        error_output = flushLines(oscilloscope, lines, false);
+                        x = startX = baseX + v[0];
+                        y = startY = baseY + v[1];
+                        lines.count = 0;
+                        if(!addPoint(lines, x, y))error_output = buffer_alloc_err;
+                        break;
+
+                    case 'L': case 'H': case 'V':
+                        if(upper == 'L')ok = number(cursor, end, &v[0]) && number(cursor, end, &v[1]);
+                        else ok = number(cursor, end, &v[0]);
+                        if(!ok)break;
+
+                        if(upper != 'V')x = baseX + v[0];
+                        if(upper == 'L')y = baseY + v[1];
+                        if(upper == 'V')y = baseY + v[0];
+                        if(lines.count == 0 && !addPoint(lines, baseX, baseY))error_output = buffer_alloc_err; //Lines drawn without a moveto start from the origin
+                        if(!addPoint(lines, x, y))error_output = buffer_alloc_err;
+                        break;
+
+                    case 'C': case 'S': case 'Q': case 'T': {
+                        const unsigned int count = (upper == 'C' ? 6 : (upper == 'T' ? 2 : 4));
+                        for(unsigned int i = 0; i < count && ok; i++)ok = number(cursor, end, &v[i]);
+                        if(!ok)break;
+
+                        error_output = flushLines(oscilloscope, lines, false);
+                        if(error_output != osc_no_err)break;
+
+                        //The mirrored control point only counts after a curve of the same kind
+                        const char last = (previous >= 'a' ? previous - ('a' - 'A') : previous);
+                        const bool mirror = (upper == 'S' ? (last == 'C' || last == 'S') : (last == 'Q' || last == 'T'));
+                        const float reflectedX = (mirror ? 2.00f * x - controlX : x);
+                        const float reflectedY = (mirror ? 2.00f * y - controlY : y);
+
+                        oscPointF p1, p2, p3;
+                        if(upper == 'C' || upper == 'S'){
+                            if(upper == 'C')p1 = {baseX + v[0], baseY + v[1]};
+                            else p1 = {reflectedX, reflectedY};
+
+                            p2 = {baseX + v[count - 4], baseY + v[count - 3]};
+                            p3 = {baseX + v[count - 2], baseY + v[count - 1]};
+                            controlX = p2.x;
+                            controlY = p2.y;
+                        } else {
+                            //Quadratic beziers are cubic ones with both control points 2/3 of the way to the quadratic control point
+                            const oscPointF q = (upper == 'Q' ? oscPointF{baseX + v[0], baseY + v[1]} : oscPointF{reflectedX, reflectedY});
+                            p3 = {baseX + v[count - 2], baseY + v[count - 1]};
+                            p1 = {x + 2.00f / 3.00f * (q.x - x), y + 2.00f / 3.00f * (q.y - y)};
+                            p2 = {p3.x + 2.00f / 3.00f * (q.x - p3.x), p3.y + 2.00f / 3.00f * (q.y - p3.y)};
+                            controlX = q.x;
+                            controlY = q.y;
+                        }
+
+                        error_output = oscilloscope.draw_bezierf({x, y}, p1, p2, p3);
+                        x = p3.x;
+                        y = p3.y;
+                        lines.count = 0;
+                        if(error_output == osc_no_err && !addPoint(lines, x, y))error_output = buffer_alloc_err;
+                        break;
+                    }
+
+                    case 'A':
+                        ok = number(cursor, end, &v[0]) && number(cursor, end, &v[1]) && number(cursor, end, &v[2]) &&
+                             flag(cursor, end, &f[0]) && flag(cursor, end, &f[1]) && number(cursor, end, &v[3]) && number(cursor, end, &v[4]);
+                        if(!ok)break;
+
+                        error_output = flushLines(oscilloscope, lines, false);
+                        if(error_output == osc_no_err)error_output = drawArc(oscilloscope, x, y, v[0], v[1], v[2], f[0], f[1], baseX + v[3], baseY + v[4]);
+                        x = baseX + v[3];
+                        y = baseY + v[4];
+                        lines.count = 0;
+                        if(error_output == osc_no_err && !addPoint(lines, x, y))error_output = buffer_alloc_err;
+                        break;
+
+                    case 'Z':
+                        if(lines.count > 0 && (lines.points[lines.count - 1].x != startX || lines.points[lines.count - 1].y != startY) && !addPoint(lines, startX, startY))error_output = buffer_alloc_err;
+                        else if(lines.count == 0 && (x != startX || y != startY))error_output = oscilloscope.draw_linef(x, y, startX, startY); //The subpath ended with a curve
+
+                        if(error_output == osc_no_err)error_output = flushLines(oscilloscope, lines, false);
+                        x = startX;
+                        y = startY;
+                        lines.count = 0;
+                        if(error_output == osc_no_err && !addPoint(lines, x, y))error_output = buffer_alloc_err;
+                        break;
+
+                    default:
+                        ok = false;
+                }
+
+                if(!ok)break;
+                previous = command;
+            }
+
+            if(error_output != osc_no_err)return error_output;
+            return flushLines(oscilloscope, lines, false);
+        } //osclib_svg::internal::drawPath
+
+        //Reads the "x,y x,y ..." list of <polyline> and <polygon>
+        osclib_err drawPoints(oscilloscopeLibrary &oscilloscope, const char *tag, bool closed, pointList &lines){
+            const char *value;
+            size_t length;
+            if(!attribute(tag, "points", &value, &length))return osc_no_err;
+
+            const char *cursor = value;
+            const char *end = value + length;
+            lines.count = 0;
+
+            float x, y;
+            while(number(cursor, end, &x) && number(cursor, end, &y)){
+                if(!addPoint(lines, x, y))return buffer_alloc_err;
+            }
+
+            if(lines.count == 0)return osc_no_err;
+            return oscilloscope.draw_polylinef(lines.points, lines.count, closed && lines.count > 2);
+        } //osclib_svg::internal::drawPoints
+
+        bool tagIs(const char *tag, const char *name){ //True if the tag's name is name, tag can still have attributes after it
+            const size_t length = strlen(name);
+            return strncmp(tag, name, length) == 0 && (tag[length] == '\0' || tag[length] == '/' || isSpace(tag[length]));
+        } //osclib_svg::internal::tagIs
+
+        //Draws the whole SVG under the transform that fits it into the screen
+        osclib_err drawFile(oscilloscopeLibrary &oscilloscope, const char *path){
+            tagReader *reader = new (std::nothrow) tagReader(); //Too big for the stack
+            if(reader == nullptr)return buffer_alloc_err;
+
+            reader->file = open(path, O_RDONLY);
+            if(reader->file < 0){
+                delete reader;
+                return file_read_err;
+            }
+
+            //Transforms of the open groups, the one at the top is the one the elements get drawn with
+            oscTransform *stack = nullptr;
+            unsigned int depth = 0;
+            unsigned int capacity = 0;
+            unsigned int hidden = 0; //Depth inside <defs> and the other elements whose content doesn't get drawn by itself
+            bool found = false; //If the file had an <svg> tag
+            bool failed = false;
+
+            pointList lines = {nullptr, 0, 0};
+            osclib_err error_output = osc_no_err;
+
+            while(error_output == osc_no_err && nextTag(*reader, &failed)){
+                const char *tag = reader->tag;
+                const bool closing = (tag[0] == '/');
+                const bool empty = (reader->tag_length > 0 && tag[reader->tag_length - 1] == '/'); //Closes itself like <g/>
+                if(closing)tag++;
+
+                const bool container = tagIs(tag, "svg") || tagIs(tag, "g") || tagIs(tag, "a") || tagIs(tag, "switch");
+                const bool hiding = tagIs(tag, "defs") || tagIs(tag, "symbol") || tagIs(tag, "clipPath") || tagIs(tag, "mask") || tagIs(tag, "marker") || tagIs(tag, "pattern");
+
+                if(hiding){
+                    if(closing && hidden > 0)hidden--;
+                    else if(!closing && !empty)hidden++;
+                    continue;
+                }
+
+                if(container){
+                    if(closing){
+                        if(depth > 0)depth--;
+                        continue;
+                    }
+                    if(empty)continue;
+
+                    if(depth == capacity){
+                        capacity = (capacity < 16 ? 16 : capacity * 2);
+                        oscTransform *grown = new (std::nothrow) oscTransform[capacity];
+                        if(grown == nullptr){
+                            error_output = buffer_alloc_err;
+                            break;
+                        }
+                        if(depth > 0)memcpy(grown, stack, depth * sizeof(oscTransform));
+                        delete[] stack;
+                        stack = grown;
+                    }
+
+                    oscTransform matrix = (depth > 0 ? stack[depth - 1] : oscilloscopeLibrary::identity_transform());
+                    if(tagIs(tag, "svg") && !found){
+                        //The outermost <svg> fits its viewBox (or its width and height) into the screen, centered and with y going up
+                        found = true;
+
+                        float box[4] = {0.00f, 0.00f, numberAttribute(tag, "width", 200.00f), numberAttribute(tag, "height", 200.00f)};
+                        const char *value;
+                        size_t length;
+                        if(attribute(tag, "viewBox", &value, &length)){
+                            const char *cursor = value;
+                            for(unsigned int i = 0; i < 4 && number(cursor, value + length, &box[i]); i++);
+                        }
+                        if(box[2] <= 0.00f)box[2] = 200.00f;
+                        if(box[3] <= 0.00f)box[3] = 200.00f;
+
+                        const float scale = 200.00f / (box[2] > box[3] ? box[2] : box[3]);
+                        const float marginX = (200.00f - box[2] * scale) / 2.00f;
+                        const float marginY = (200.00f - box[3] * scale) / 2.00f;
+                        matrix = {scale, 0.00f, 0.00f, -scale, marginX - box[0] * scale, 200.00f - marginY + box[1] * scale};
+                    }
+                    transformAttribute(tag, &matrix);
+                    stack[depth++] = matrix;
+                    continue;
+                }
+
+                if(closing || hidden > 0 || !found)continue;
+
+                //Only elements that draw something get here
+                const bool path = tagIs(tag, "path"), line = tagIs(tag, "line"), polyline = tagIs(tag, "polyline"), polygon = tagIs(tag, "polygon");
+                const bool rect = tagIs(tag, "rect"), circle = tagIs(tag, "circle"), ellipse = tagIs(tag, "ellipse");
+                if(!(path || line || polyline || polygon || rect || circle || ellipse))continue;
+
+                oscTransform matrix = (depth > 0 ? stack[depth - 1] : oscilloscopeLibrary::identity_transform());
+                transformAttribute(tag, &matrix);
+                oscilloscope.set_transform(matrix); //Everything drawn before this goes through the transform it was drawn with
+
+                if(path){
+                    const char *value;
+                    size_t length;
+                    if(attribute(tag, "d", &value, &length))error_output = drawPath(oscilloscope, value, length, lines);
+                } else if(line){
+                    error_output = oscilloscope.draw_linef(numberAttribute(tag, "x1", 0.00f), numberAttribute(tag, "y1", 0.00f), numberAttribute(tag, "x2", 0.00f), numberAttribute(tag, "y2", 0.00f));
+                } else if(polyline || polygon){
+                    error_output = drawPoints(oscilloscope, tag, polygon, lines);
+                } else if(rect){
+                    const float x = numberAttribute(tag, "x", 0.00f), y = numberAttribute(tag, "y", 0.00f);
+                    const float width = numberAttribute(tag, "width", 0.00f), height = numberAttribute(tag, "height", 0.00f);
+                    const oscPointF corners[4] = {{x, y}, {x + width, y}, {x + width, y + height}, {x, y + height}};
+                    if(width > 0.00f && height > 0.00f)error_output = oscilloscope.draw_polylinef(corners, 4, true);
+                } else {
+                    const float cx = numberAttribute(tag, "cx", 0.00f), cy = numberAttribute(tag, "cy", 0.00f);
+                    const float rx = numberAttribute(tag, (circle ? "r" : "rx"), 0.00f);
+                    const float ry = (circle ? rx : numberAttribute(tag, "ry", 0.00f));
+                    if(rx > 0.00f && ry > 0.00f)error_output = oscilloscope.draw_ellipsef(cx, cy, rx, ry);
+                }
+            }
+
+            close(reader->file);
+            delete[] reader->tag;
+            delete reader;
+            delete[] stack;
+            delete[] lines.points;
+
+            if(error_output != osc_no_err)return error_output;
+            if(failed)return file_read_err;
+            return (found ? osc_no_err : file_format_err);
+        } //osclib_svg::internal::drawFile
+
+        bool readAll(int file, void *data, size_t bytes){
+            char *cursor = (char*)data;
+            while(bytes > 0){
+                ssize_t done = read(file, cursor, bytes);
+                if(done <= 0)return false;
+                cursor += done;
+                bytes -= done;
+            }
+            return true;
+        } //osclib_svg::internal::readAll
+
+        bool writeAll(int file, const void *data, size_t bytes){
+            const char *cursor = (const char*)data;
+            while(bytes > 0){
+                ssize_t done = write(file, cursor, bytes);
+                if(done <= 0)return false;
+                cursor += done;
+                bytes -= done;
+            }
+            return true;
+        } //osclib_svg::internal::writeAll
+
+        //Cache file: the magic, the hash, the sample density, the number of samples and of blocks, every block's length, then all the left samples and all the right ones
+        //Everything is in the byte order of the machine that wrote it, the cache is only meant for the machine it was made on
+        typedef struct {
+            char magic[8];
+            unsigned long long hash;
+            float density;
+            unsigned int frames;
+            unsigned int blocks;
+        } cacheHeader;
+
+        //Draws the samples saved in the cache, false if there's no cache for this version of the file (nothing gets drawn then)
+        bool drawCache(oscilloscopeLibrary &oscilloscope, const char *cache_path, unsigned long long hash, osclib_err *error_output){
+            int file = open(cache_path, O_RDONLY);
+            if(file < 0)return false;
+
+            cacheHeader header;
+            if(!readAll(file, &header, sizeof(header)) || memcmp(header.magic, SVG_CACHE_MAGIC, 8) != 0 || header.hash != hash || header.density != oscilloscope.sample_density()){
+                close(file);
+                return false;
+            }
+
+            unsigned int *blocks = new (std::nothrow) unsigned int[header.blocks];
+            float *left = new (std::nothrow) float[header.frames];
+            float *right = new (std::nothrow) float[header.frames];
+
+            bool valid = (blocks != nullptr && left != nullptr && right != nullptr);
+            valid = valid && readAll(file, blocks, header.blocks * sizeof(unsigned int));
+            valid = valid && readAll(file, left, header.frames * sizeof(float)) && readAll(file, right, header.frames * sizeof(float));
+            close(file);
+
+            unsigned long long total = 0;
+            for(unsigned int i = 0; valid && i < header.blocks; i++)total += blocks[i];
+            valid = valid && (total == header.frames);
+
+            *error_output = osc_no_err;
+            if(valid){
+                //One draw_samples() for every block so the draw order optimizer can still move them
+                unsigned int position = 0;
+                for(unsigned int i = 0; i < header.blocks && *error_output == osc_no_err; i++){
+                    *error_output = oscilloscope.draw_samples(left + position, right + position, blocks[i]);
+                    position += blocks[i];
+                }
+            }
+
+            delete[] blocks;
+            delete[] left;
+            delete[] right;
+            return valid;
+        } //osclib_svg::internal::drawCache
+
+        void writeCache(oscilloscopeLibrary &oscilloscope, unsigned int id, const char *cache_path, unsigned long long hash){ //The cache is only there to save time, if it can't be written the next load just parses the file again
+            const float *left, *right;
+            const paBlock *blocks;
+            unsigned int frames, block_count;
+            if(oscilloscope.scene_samples(id, &left, &right, &frames, &blocks, &block_count) != osc_no_err)return;
+
+            int file = open(cache_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if(file < 0)return;
+
+            cacheHeader header;
+            memcpy(header.magic, SVG_CACHE_MAGIC, 8);
+            header.hash = hash;
+            header.density = oscilloscope.sample_density();
+            header.frames = frames;
+            header.blocks = block_count;
+
+            bool written = writeAll(file, &header, sizeof(header));
+            for(unsigned int i = 0; written && i < block_count; i++)written = writeAll(file, &blocks[i].length, sizeof(unsigned int)); //The blocks of an object are one after the other so the starts aren't needed
+            written = written && writeAll(file, left, frames * sizeof(float)) && writeAll(file, right, frames * sizeof(float));
+            close(file);
+
+            if(!written)unlink(cache_path); //A cut file would never match anyway, but there's no point keeping it
+        } //osclib_svg::internal::writeCache
+    } //namespace osclib_svg::internal
+
+    //Creates a scene object with the drawing of the SVG file at path and writes its id into id
+    //cache_path is where the samples get cached, SVG_CACHE_NEXT_TO_FILE puts them next to the SVG (path + ".osccache") and nullptr doesn't cache anything
+    //The cache only gets used if the SVG file and the sample density are the same as when it was written
+    osclib_err load(oscilloscopeLibrary &oscilloscope, const char *path, unsigned int *id, const char *cache_path = SVG_CACHE_NEXT_TO_FILE){
+        char *default_cache = nullptr;
+        if(cache_path != nullptr && cache_path[0] == '\0'){
+            const size_t length = strlen(path) + strlen(SVG_CACHE_EXTENSION) + 1;
+            default_cache = new (std::nothrow) char[length];
+            if(default_cache == nullptr)return buffer_alloc_err;
+
+            snprintf(default_cache, length, "%s%s", path, SVG_CACHE_EXTENSION);
+            cache_path = default_cache;
+        }
+
+        unsigned long long hash = 0;
+        if(!internal::hashFile(path, &hash)){
+            delete[] default_cache;
+            return file_read_err;
+        }
+
+        osclib_err error_output = oscilloscope.scene_add(id);
+        if(error_output != osc_no_err){
+            delete[] default_cache;
+            return error_output;
+        }
+
+        error_output = oscilloscope.scene_begin(*id);
+        if(error_output == osc_no_err){
+            error_output = oscilloscope.push_transform(); //The caller's transform doesn't apply, the object gets placed with scene_move() and scene_transform()
+            if(error_output != osc_no_err)oscilloscope.scene_end(); //Otherwise the library would stay recording into the object
+        }
+        if(error_output != osc_no_err){ //Not leaving an empty object behind
+            oscilloscope.scene_remove(*id);
+            *id = 0;
+            delete[] default_cache;
+            return error_output;
+        }
+
+        bool cached = false;
+        if(cache_path != nullptr){
+            oscilloscope.reset_transform(); //The cached samples already went through the SVG's transforms
+            cached = internal::drawCache(oscilloscope, cache_path, hash, &error_output);
+        }
+        if(!cached)error_output = internal::drawFile(oscilloscope, path);
+
+        oscilloscope.pop_transform(); //This is also what runs the last element through its transform
+        oscilloscope.scene_end();
+
+        if(error_output == osc_no_err && !cached && cache_path != nullptr)internal::writeCache(oscilloscope, *id, cache_path, hash);
+        if(error_output != osc_no_err){
+            oscilloscope.scene_remove(*id);
+            *id = 0;
+        }
+
+        delete[] default_cache;
+        return error_output;
+    } //osclib_svg::load
+} //namespace osclib_svg
+
+#endif
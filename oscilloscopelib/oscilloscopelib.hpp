@@ -3,40 +3,1039 @@
 
 #include "portaudio.h"
 #include "customTerminalIO.hpp"
+#include "oscilloscopeFont.hpp"
 #include <cmath>
+#include <atomic>
+#include <new>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#if defined(__AVX__) || defined(__SSE2__)
+    #include <immintrin.h>
+#endif
 
 #define DEFAULT_SAMPLE_RATE (44100)
+#define DEFAULT_DENSITY (1.00f) //Samples per unit of length (0.01) used by lines and curves
+#define MIN_CURVE_STEPS (8) //Even the smallest circle gets at least this many samples so it doesn't turn into a polygon with a couple of sides
+
+#define MAX_OVERSAMPLING (16) //Highest factor set_oversampling() accepts
+#define TRANSFORM_STACK_DEPTH (32) //Number of transforms push_transform() can save
+#define MIN_REFRESH_RATE (1.00f) //Lowest refresh rate set_refresh_rate() accepts, anything below it turns the fixed budget off
+
+#define ORDER_GRID_SIZE (32) //The draw order optimizer splits the screen in up to ORDER_GRID_SIZE x ORDER_GRID_SIZE cells to find the nearest primitive quickly
+#define ORDER_2OPT_WINDOW (24) //2-opt only tries reversing runs of up to this many primitives, a full 2-opt is quadratic and too slow for big frames
+#define ORDER_2OPT_PASSES (4) //Maximum number of 2-opt passes over the whole frame
+#define PARALLEL_MIN_SAMPLES (16384) //Batches with less samples than this are always drawn on the caller's thread, waking the workers would cost more than it saves
+#define PARALLEL_CHUNKS_PER_THREAD (8) //A parallel batch gets split in this many chunks per thread so the threads that finish early can take work from the others
+#define DEFAULT_FRAMES_PER_BUFFER (128) //Device period used by open_start(), it doesn't depend on how big the drawn frame is
+#define OSC_DEFAULT_DEVICE (-1)   //oscStreamConfig::device value for the default output device of the host API
+#define OSC_DEFAULT_HOST_API (-1) //oscStreamConfig::host_api value for portAudio's default host API
+#define OSC_DEFAULT_LATENCY (0.00) //oscStreamConfig::latency value for the device's default latency for robust playback, same as Pa_OpenDefaultStream()
+#define OSC_LOW_LATENCY (-1.00)    //oscStreamConfig::latency value for the device's default low latency
+#define DEVICE_NAME_LENGTH (128)  //Longest device name list_devices() keeps, longer ones get cut
+#define STREAM_DEFAULT_DEPTH (16384) //Stereo pairs the streaming ring holds, about 100ms at DEFAULT_SAMPLE_RATE
+#define STREAM_DEFAULT_HIGH_WATERMARK (12288) //The producer stops once the ring holds this many pairs
+#define STREAM_DEFAULT_LOW_WATERMARK (4096)   //And starts again once the callback drained it down to this many
+#define STREAM_DEFAULT_BLOCK_FRAMES (512)     //Pairs the producer function gets asked for at a time
+#define CACHE_LINE_SIZE (64) //The interleaved frames are aligned to this so the callback never copies a cache line shared with something else
+#define SCRATCH_BYTES_PER_PRIMITIVE (38) //Scratch arena memory the optimizer and the sample budget need for every primitive of a frame
+#define HEALTH_HISTOGRAM_BUCKETS (16) //Callback times get counted in power of two buckets of microseconds, the last one counts everything above 16ms
+#define RENDER_BLOCK_FRAMES (4096) //Number of frames render_to_file() renders and writes at a time
+
+#define GLYPH_SAMPLES_PER_UNIT (4) //Samples per unit of the glyph grid used when the font gets compiled, this doesn't change with the text's scale
+#define GLYPH_ADVANCE (OSCFONT_WIDTH + 2) //Distance between two characters in glyph units
+#define GLYPH_LINE_HEIGHT (OSCFONT_HEIGHT + 3) //Distance between two lines of text in glyph units
+
+//Tracing: define OSCLIB_TRACE_LEVEL before including this header to turn it on
+//At level 0 (the default) every OSC_TRACE() compiles to nothing, otherwise the traces up to that level get stored into a ring in memory
+//and nothing gets printed until osclib_trace::dump() is called, so tracing never makes a syscall on the drawing path
+#ifndef OSCLIB_TRACE_LEVEL
+    #define OSCLIB_TRACE_LEVEL 0
+#endif
+
+//Allocation hooks: the frames' interleaved samples and the scratch arena are cache line aligned and don't go through new, define these before including this header
+//to count or redirect those allocations (oscilloscopelibbench.cpp does), everything else is allocated with new and new[]
+#ifndef OSCLIB_ALIGNED_ALLOC
+    #define OSCLIB_ALIGNED_ALLOC(alignment, bytes) std::aligned_alloc((alignment), (bytes))
+#endif
+#ifndef OSCLIB_ALIGNED_FREE
+    #define OSCLIB_ALIGNED_FREE(memory) std::free(memory)
+#endif
+
+#define OSC_TRACE_ERROR 1
+#define OSC_TRACE_INFO  2
+#define OSC_TRACE_DEBUG 3
+
+#define OSCLIB_TRACE_RING_SIZE (1024) //Number of traces kept, the oldest ones get overwritten
+
+#if OSCLIB_TRACE_LEVEL > 0
+    //The message must be a string literal since only its pointer is stored, up to 4 numbers can follow it
+    #define OSC_TRACE(level, ...) do{ if constexpr((level) <= OSCLIB_TRACE_LEVEL)osclib_trace::record((level), __VA_ARGS__); }while(0)
+#else
+    #define OSC_TRACE(level, ...) do{}while(0)
+#endif
+
+//This namespace contains the in-memory trace ring used by OSC_TRACE()
+namespace osclib_trace {
+    #if OSCLIB_TRACE_LEVEL > 0
+        typedef struct {
+            int level;
+            const char *message; //Not copied, this is why it has to be a string literal
+            unsigned int values_count;
+            double values[4]; //The numbers are only formatted when the ring gets dumped
+        } traceEntry;
+
+        static traceEntry ring[OSCLIB_TRACE_RING_SIZE];
+        static std::atomic<unsigned long> written{0}; //Total number of traces recorded, the ring position is this modulo the ring size
+
+        template <typename... args>
+        void record(int level, const char *message, args... values){
+            static_assert(sizeof...(values) <= 4, "OSC_TRACE() takes at most 4 numbers after the message");
+
+            traceEntry &entry = ring[written.fetch_add(1, std::memory_order_relaxed) % OSCLIB_TRACE_RING_SIZE];
+            entry.level = level;
+            entry.message = message;
+            entry.values_count = sizeof...(values);
+
+            const double converted[] = {0.00, (double)values...}; //The first element is only there so the array is never empty
+            for(unsigned int i = 0; i < sizeof...(values); i++)entry.values[i] = converted[i + 1];
+        } //osclib_trace::record
+    #endif
+
+    //Prints every trace still in the ring from the oldest to the newest and empties it
+    void dump(){
+        #if OSCLIB_TRACE_LEVEL > 0
+            const char *level_names[] = {"", "[error] ", "[info] ", "[debug] "};
+
+            unsigned long end = written.load(std::memory_order_acquire);
+            unsigned long start = (end > OSCLIB_TRACE_RING_SIZE ? end - OSCLIB_TRACE_RING_SIZE : 0);
+
+            for(unsigned long i = start; i < end; i++){
+                const traceEntry &entry = ring[i % OSCLIB_TRACE_RING_SIZE];
+
+                terminal::out::print(level_names[entry.level], entry.message);
+                for(unsigned int v = 0; v < entry.values_count; v++)terminal::out::print(" ", (long double)entry.values[v]);
+                terminal::out::print(ENDLINE);
+            }
+
+            written.store(0, std::memory_order_release);
+        #endif
+    } //osclib_trace::dump
+} //namespace osclib_trace
+
+typedef struct {
+    unsigned int start;  //Position of the primitive's first sample into the frame
+    unsigned int length; //Number of samples of the primitive
+} paBlock;
 
 typedef struct {
     float *left_channel;
     float *right_channel;
 
-    unsigned int buffer_frames;
+    unsigned int buffer_frames;   //Number of samples drawn into the frame, it's also the position where the next primitive gets written
+    unsigned int buffer_capacity; //Number of samples both channels can hold before they need to grow, it only ever grows so a cleared frame keeps its memory
+
+    float *interleaved; //The finished frame as left/right pairs, the way portAudio wants it, it gets filled once by publish_frame() so the callback only has to copy it
+    unsigned int interleaved_capacity; //Number of stereo pairs interleaved can hold
+    unsigned int interleaved_frames; //Number of stereo pairs in interleaved, it's what the callback plays and it can differ from buffer_frames when a refresh rate is set
+
+    paBlock *blocks; //Where every primitive drawn into the frame is, in the order they were drawn, used to reorder them before the frame gets published
+    unsigned int block_count;
+    unsigned int block_capacity;
 } paData;
-static paData preBufData;
+
+typedef struct { //Only the callback writes these, with relaxed atomics, so the application can read them at any time without ever making the callback wait
+    std::atomic<unsigned long> callbacks;
+    std::atomic<unsigned long> output_underflows;
+    std::atomic<unsigned long> output_overflows;
+    std::atomic<unsigned long> priming;
+    std::atomic<unsigned long> swaps; //Number of times the callback picked up a frame different from the one it was playing
+
+    std::atomic<unsigned long> time_histogram[HEALTH_HISTOGRAM_BUCKETS];
+    std::atomic<unsigned long> time_total; //Nanoseconds
+    std::atomic<unsigned long> time_max;
+
+    std::atomic<unsigned long> jitter_count; //Number of callbacks the jitter could be measured on, it needs the DAC time of the one before
+    std::atomic<unsigned long> jitter_total; //Nanoseconds
+    std::atomic<unsigned long> jitter_max;
+
+    std::atomic<unsigned long> stream_underruns; //Callbacks that found the streaming ring with less samples than they needed
+
+    double last_dac_time; //outputBufferDacTime of the last callback, 0 if it wasn't known
+    unsigned long last_frames; //framesPerBuffer of the last callback
+    const void *last_played; //Frame the callback played before picking up the current one
+} paHealth;
+
+typedef struct { //Single producer single consumer ring of stereo pairs, the producer only moves write and the callback only moves read so neither ever waits for the other
+    float *samples; //Interleaved left/right pairs
+    unsigned long mask; //Capacity in pairs - 1, the capacity is a power of two so the positions just get masked
+
+    alignas(CACHE_LINE_SIZE) std::atomic<unsigned long> write; //Pairs written since the ring got created, they only ever grow
+    alignas(CACHE_LINE_SIZE) std::atomic<unsigned long> read;  //Pairs played, on its own cache line so the two sides don't keep stealing it from each other
+
+    float hold_left; //Last pair played, it's held when the ring runs dry so the beam stays still instead of jumping to the center
+    float hold_right;
+} paRing;
+
+typedef struct {
+    paData frames[2]; //The front and the back frame, the application draws into one of them while the callback plays the other one
+
+    std::atomic<paData*> front;   //The last frame published by the application, the callback picks it up when it reaches the end of the frame it's playing
+    std::atomic<paData*> playing; //The frame the callback is currently playing, the application waits on this before drawing into the old front frame again
+
+    unsigned long cursor; //Position of the callback inside the playing frame, it's kept between callbacks and only ever touched by the callback
+    paData *cursor_frame; //The frame cursor is a position in, if playing got changed by the application (while streaming or without a stream) the cursor starts again from 0
+
+    std::atomic<paRing*> stream;         //The streaming ring, when it's set the callback plays the ring instead of the frames
+    std::atomic<paRing*> stream_reading; //The ring the last callback played, the application waits on this before freeing the ring
+
+    unsigned int sample_rate; //Of the open stream, used to know how far apart two callbacks should be
+    paHealth health;
+} paFrameSwap;
+
+typedef struct {
+    float *x; //Samples of every glyph back to back, in glyph units
+    float *y;
+
+    unsigned int start[OSCFONT_GLYPHS];  //Where every glyph's samples start
+    unsigned int length[OSCFONT_GLYPHS]; //How many samples every glyph has
+
+    std::atomic<bool> compiled;
+    std::mutex lock; //Two instances drawing text on different threads could try to compile the font at the same time
+} glyphCache;
+static glyphCache fontCache; //The font only gets rasterized once, draw_text() just scales and moves these samples
+
+typedef struct { //The arrays are taken from the scratch arena every time a frame gets published
+    unsigned int *order;    //Blocks in the order they will be emitted
+    unsigned char *flipped; //1 for the blocks that get emitted backwards
+    unsigned char *visited; //Used by the nearest neighbour pass
+    float *ends; //x and y of the first and last sample of every block, 4 floats per block
+    float *jumps; //Length of the jump after every block in the order, used by the 2-opt pass
+    unsigned int *cell_items; //Block ends sorted by grid cell, every block has two: block * 2 is its start and block * 2 + 1 its end
+    unsigned int cell_start[ORDER_GRID_SIZE * ORDER_GRID_SIZE + 1]; //Where every cell's items start in cell_items
+    unsigned int cell_end[ORDER_GRID_SIZE * ORDER_GRID_SIZE]; //Where they end, ends of blocks already drawn get moved past it while searching
+    int grid_size; //Cells per side, smaller grids for frames with few blocks so the search doesn't go through lots of empty cells
+} orderScratch;
+
+typedef struct {
+    unsigned int x; //Same 0 to 200 scale used by draw_line() and draw_point()
+    unsigned int y;
+} oscPoint;
+
+typedef struct {
+    oscPoint start;
+    oscPoint end;
+} oscSegment;
+
+typedef struct { //Same scale as oscPoint but with fractions, and it can go outside of the screen
+    float x;
+    float y;
+} oscPointF;
+
+typedef struct {
+    oscPointF start;
+    oscPointF end;
+} oscSegmentF;
+
+typedef struct { //2x3 affine matrix in the 0 to 200 units, it maps x y to a * x + c * y + e, b * x + d * y + f (the same order as SVG's matrix())
+    float a, b;
+    float c, d;
+    float e, f;
+} oscTransform;
+
+typedef struct {
+    paData samples; //What got drawn into the object between scene_begin() and scene_end(), only the channels and the blocks are used
+    int x; //Offset the object gets drawn at, in the same units as draw_line(), set with scene_move()
+    int y;
+    oscTransform transform; //Applied before the offset, set with scene_transform()
+    bool visible;
+} sceneObject;
+
+typedef struct { //Everything open_stream() needs to know, stream_config() gives one with the same settings open_start() uses
+    int device;   //Index of the device as given by list_devices(), or OSC_DEFAULT_DEVICE
+    int host_api; //A PaHostApiTypeId like paALSA or paJACK, or OSC_DEFAULT_HOST_API, it only matters if device is OSC_DEFAULT_DEVICE
+    unsigned int sample_rate;
+    unsigned long frames_per_buffer; //Device period, paFramesPerBufferUnspecified (0) lets the host API choose and it's the best choice with JACK
+    double latency; //Suggested output latency in seconds, or OSC_DEFAULT_LATENCY or OSC_LOW_LATENCY, the host API can give a different one (see output_latency())
+} oscStreamConfig;
+
+typedef struct { //An output device, filled by list_devices()
+    int index; //What goes into oscStreamConfig::device
+    char name[DEVICE_NAME_LENGTH];
+    char host_api_name[DEVICE_NAME_LENGTH];
+    int host_api; //PaHostApiTypeId
+    int max_output_channels;
+    double default_low_latency;  //Seconds
+    double default_high_latency;
+    double default_sample_rate;
+    bool is_default; //Default output device of its host API
+} oscDeviceInfo;
+
+typedef unsigned long (*oscStreamProducer)(float *output, unsigned long frames, void *user_data); //Writes up to frames interleaved left/right pairs into output and returns how many it wrote
+
+typedef struct { //Ring and watermarks used by start_streaming(), streaming_config() gives the default ones
+    unsigned int depth; //Stereo pairs the ring holds, rounded up to a power of two
+    unsigned int high_watermark; //The producer thread stops filling the ring once it holds this many pairs
+    unsigned int low_watermark;  //And starts again once it's down to this many, the gap keeps it from waking up for every callback
+    unsigned int block_frames; //Pairs the producer function gets asked for at a time
+} oscStreamingConfig;
+
+typedef struct { //Filled by health(), everything is counted from when the stream got opened or from the last reset_health()
+    unsigned long callbacks;
+    unsigned long output_underflows; //Buffers where the device ran out of samples before the callback gave it new ones (paOutputUnderflow), the beam stops for a moment
+    unsigned long output_overflows;  //paOutputOverflow
+    unsigned long priming_callbacks; //Buffers asked before the stream actually started playing (paPrimingOutput)
+
+    unsigned long callback_time_histogram[HEALTH_HISTOGRAM_BUCKETS]; //Bucket 0 counts the callbacks that took less than 1us, bucket i the ones that took from 2^(i-1) to 2^i us
+    double callback_time_mean; //Seconds
+    double callback_time_max;
+
+    //Difference between how far apart two callbacks' outputBufferDacTime were and how far apart they should have been, only measured if the host API gives the DAC time
+    double jitter_mean; //Seconds
+    double jitter_max;
+
+    unsigned long stream_underruns; //Callbacks where the streaming ring ran dry, the beam held its last position for the missing samples
+
+    unsigned long frames_swapped; //Published frames the callback started playing
+    double swaps_per_second; //Since the previous health() call
+} oscHealth;
+
+//This namespace contains the vectorized kernels used by the library, every kernel has a scalar version for the CPUs without SSE or AVX
+namespace osclib_simd {
+    //Merges the two channels into left/right pairs, out must have room for frames * 2 floats
+    void interleave(const float *left, const float *right, float *out, unsigned int frames){
+        unsigned int i = 0;
+
+        #if defined(__AVX__)
+            for(; i + 8 <= frames; i += 8){
+                __m256 l = _mm256_loadu_ps(left + i);
+                __m256 r = _mm256_loadu_ps(right + i);
+
+                __m256 low  = _mm256_unpacklo_ps(l, r); //l0 r0 l1 r1 | l4 r4 l5 r5
+                __m256 high = _mm256_unpackhi_ps(l, r); //l2 r2 l3 r3 | l6 r6 l7 r7
+
+                _mm256_storeu_ps(out + i * 2,     _mm256_permute2f128_ps(low, high, 0x20)); //l0 r0 l1 r1 l2 r2 l3 r3
+                _mm256_storeu_ps(out + i * 2 + 8, _mm256_permute2f128_ps(low, high, 0x31)); //l4 r4 l5 r5 l6 r6 l7 r7
+            }
+        #elif defined(__SSE2__)
+            for(; i + 4 <= frames; i += 4){
+                __m128 l = _mm_loadu_ps(left + i);
+                __m128 r = _mm_loadu_ps(right + i);
+
+                _mm_storeu_ps(out + i * 2,     _mm_unpacklo_ps(l, r)); //l0 r0 l1 r1
+                _mm_storeu_ps(out + i * 2 + 4, _mm_unpackhi_ps(l, r)); //l2 r2 l3 r3
+            }
+        #endif
+
+        for(; i < frames; i++){ //Scalar tail (or the whole thing if there's no SIMD)
+            out[i * 2]     = left[i];
+            out[i * 2 + 1] = right[i];
+        }
+    } //osclib_simd::interleave
+
+    //Same as interleave() but the samples are written from the last to the first, used to draw a primitive backwards
+    void interleaveReversed(const float *left, const float *right, float *out, unsigned int frames){
+        unsigned int i = 0;
+
+        #if defined(__SSE2__)
+            for(; i + 4 <= frames; i += 4){
+                //Loading the 4 samples that end up in out[i] to out[i + 3] and reversing their order
+                __m128 l = _mm_shuffle_ps(_mm_loadu_ps(left + frames - i - 4),  _mm_loadu_ps(left + frames - i - 4),  _MM_SHUFFLE(0, 1, 2, 3));
+                __m128 r = _mm_shuffle_ps(_mm_loadu_ps(right + frames - i - 4), _mm_loadu_ps(right + frames - i - 4), _MM_SHUFFLE(0, 1, 2, 3));
+
+                _mm_storeu_ps(out + i * 2,     _mm_unpacklo_ps(l, r));
+                _mm_storeu_ps(out + i * 2 + 4, _mm_unpackhi_ps(l, r));
+            }
+        #endif
+
+        for(; i < frames; i++){
+            out[i * 2]     = left[frames - i - 1];
+            out[i * 2 + 1] = right[frames - i - 1];
+        }
+    } //osclib_simd::interleaveReversed
+
+    //Writes n samples going from start with a fixed step: out[i] = start + i * step
+    //Every sample is computed from its index and not from the previous one so the error doesn't pile up along the line
+    void ramp(float *out, float start, float step, unsigned int n){
+        unsigned int i = 0;
+
+        #if defined(__AVX__)
+            const __m256 lanes  = _mm256_set_ps(7.00f, 6.00f, 5.00f, 4.00f, 3.00f, 2.00f, 1.00f, 0.00f);
+            const __m256 starts = _mm256_set1_ps(start);
+            const __m256 steps  = _mm256_set1_ps(step);
+
+            for(; i + 8 <= n; i += 8){
+                __m256 index = _mm256_add_ps(_mm256_set1_ps((float)i), lanes);
+                _mm256_storeu_ps(out + i, _mm256_add_ps(starts, _mm256_mul_ps(index, steps)));
+            }
+        #elif defined(__SSE2__)
+            const __m128 lanes  = _mm_set_ps(3.00f, 2.00f, 1.00f, 0.00f);
+            const __m128 starts = _mm_set1_ps(start);
+            const __m128 steps  = _mm_set1_ps(step);
+
+            for(; i + 4 <= n; i += 4){
+                __m128 index = _mm_add_ps(_mm_set1_ps((float)i), lanes);
+                _mm_storeu_ps(out + i, _mm_add_ps(starts, _mm_mul_ps(index, steps)));
+            }
+        #endif
+
+        for(; i < n; i++)out[i] = start + (float)i * step; //Scalar tail (or the whole thing if there's no SIMD)
+    } //osclib_simd::ramp
+
+    //Scales and moves n samples: out[i] = in[i] * scale + offset
+    void scaleOffset(const float *in, float *out, float scale, float offset, unsigned int n){
+        unsigned int i = 0;
+
+        #if defined(__AVX__)
+            const __m256 scales  = _mm256_set1_ps(scale);
+            const __m256 offsets = _mm256_set1_ps(offset);
+
+            for(; i + 8 <= n; i += 8)_mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(in + i), scales), offsets));
+        #elif defined(__SSE2__)
+            const __m128 scales  = _mm_set1_ps(scale);
+            const __m128 offsets = _mm_set1_ps(offset);
+
+            for(; i + 4 <= n; i += 4)_mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(in + i), scales), offsets));
+        #endif
+
+        for(; i < n; i++)out[i] = in[i] * scale + offset;
+    } //osclib_simd::scaleOffset
+
+    //Runs n points through a 2x3 affine matrix {a, b, c, d, e, f}: outX = a * x + c * y + e, outY = b * x + d * y + f, in and out can be the same
+    void affine(const float *inX, const float *inY, float *outX, float *outY, unsigned int n, const float *matrix){
+        unsigned int i = 0;
+
+        #if defined(__AVX__)
+            const __m256 a = _mm256_set1_ps(matrix[0]), b = _mm256_set1_ps(matrix[1]);
+            const __m256 c = _mm256_set1_ps(matrix[2]), d = _mm256_set1_ps(matrix[3]);
+            const __m256 e = _mm256_set1_ps(matrix[4]), f = _mm256_set1_ps(matrix[5]);
+
+            for(; i + 8 <= n; i += 8){
+                const __m256 x = _mm256_loadu_ps(inX + i);
+                const __m256 y = _mm256_loadu_ps(inY + i);
+
+                _mm256_storeu_ps(outX + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a, x), _mm256_mul_ps(c, y)), e));
+                _mm256_storeu_ps(outY + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(b, x), _mm256_mul_ps(d, y)), f));
+            }
+        #elif defined(__SSE2__)
+            const __m128 a = _mm_set1_ps(matrix[0]), b = _mm_set1_ps(matrix[1]);
+            const __m128 c = _mm_set1_ps(matrix[2]), d = _mm_set1_ps(matrix[3]);
+            const __m128 e = _mm_set1_ps(matrix[4]), f = _mm_set1_ps(matrix[5]);
+
+            for(; i + 4 <= n; i += 4){
+                const __m128 x = _mm_loadu_ps(inX + i);
+                const __m128 y = _mm_loadu_ps(inY + i);
+
+                _mm_storeu_ps(outX + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, x), _mm_mul_ps(c, y)), e));
+                _mm_storeu_ps(outY + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(b, x), _mm_mul_ps(d, y)), f));
+            }
+        #endif
+
+        for(; i < n; i++){
+            const float x = inX[i];
+            const float y = inY[i];
+
+            outX[i] = matrix[0] * x + matrix[2] * y + matrix[4];
+            outY[i] = matrix[1] * x + matrix[3] * y + matrix[5];
+        }
+    } //osclib_simd::affine
+
+    //upsample() for the even factors, the weights stay in registers and every input pair is loaded once
+    template<unsigned int factor>
+    void upsampleFixed(const float *in, float *out, unsigned int frames){
+        float weights[factor * 2]; //Position of every output pair between two input pairs, twice since they're pairs: 0 0 1/f 1/f 2/f 2/f ...
+        for(unsigned int k = 0; k < factor; k++)weights[k * 2] = weights[k * 2 + 1] = (float)k / factor;
+
+        #if defined(__AVX__) || defined(__SSE2__)
+            //A pair is loaded as one double and repeated over the whole register: x y x y ...
+            #if defined(__AVX__)
+            if constexpr(factor % 4 == 0){
+                __m256 lanes[factor / 4];
+                for(unsigned int j = 0; j < factor / 4; j++)lanes[j] = _mm256_loadu_ps(weights + j * 8);
+
+                __m256 from = _mm256_castpd_ps(_mm256_broadcast_sd((const double*)in));
+                for(unsigned int i = 0; i < frames; i++){
+                    const __m256 to = _mm256_castpd_ps(_mm256_broadcast_sd((const double*)(in + (i + 1 < frames ? i + 1 : 0) * 2)));
+                    const __m256 delta = _mm256_sub_ps(to, from);
+
+                    for(unsigned int j = 0; j < factor / 4; j++)_mm256_storeu_ps(out + (i * factor + j * 4) * 2, _mm256_add_ps(from, _mm256_mul_ps(delta, lanes[j])));
+                    from = to;
+                }
+                return;
+            }
+            #endif
+
+            __m128 lanes[factor / 2];
+            for(unsigned int j = 0; j < factor / 2; j++)lanes[j] = _mm_loadu_ps(weights + j * 4);
+
+            __m128 from = _mm_castpd_ps(_mm_load1_pd((const double*)in));
+            for(unsigned int i = 0; i < frames; i++){
+                const __m128 to = _mm_castpd_ps(_mm_load1_pd((const double*)(in + (i + 1 < frames ? i + 1 : 0) * 2)));
+                const __m128 delta = _mm_sub_ps(to, from);
+
+                for(unsigned int j = 0; j < factor / 2; j++)_mm_storeu_ps(out + (i * factor + j * 2) * 2, _mm_add_ps(from, _mm_mul_ps(delta, lanes[j])));
+                from = to;
+            }
+        #else
+            for(unsigned int i = 0; i < frames; i++){
+                const float *from = in + i * 2;
+                const float *to = in + (i + 1 < frames ? i + 1 : 0) * 2;
+
+                for(unsigned int j = 0; j < factor * 2; j += 2){
+                    out[i * factor * 2 + j]     = from[0] + (to[0] - from[0]) * weights[j];
+                    out[i * factor * 2 + j + 1] = from[1] + (to[1] - from[1]) * weights[j + 1];
+                }
+            }
+        #endif
+    } //osclib_simd::upsampleFixed
+
+    //Linear interpolation of frames left/right pairs to factor times as many, out must have room for frames * factor * 2 floats
+    //The last pair goes towards the first one since the frame gets played in a loop
+    void upsample(const float *in, float *out, unsigned int frames, unsigned int factor){
+        if(frames == 0)return;
+
+        switch(factor){ //The common factors get a kernel of their own, the generic loop below is about twice as slow
+            case 2:  upsampleFixed<2>(in, out, frames);  return;
+            case 4:  upsampleFixed<4>(in, out, frames);  return;
+            case 8:  upsampleFixed<8>(in, out, frames);  return;
+            case 16: upsampleFixed<16>(in, out, frames); return;
+        }
+
+        float weights[MAX_OVERSAMPLING * 2];
+        for(unsigned int k = 0; k < factor; k++)weights[k * 2] = weights[k * 2 + 1] = (float)k / factor;
+
+        for(unsigned int i = 0; i < frames; i++){
+            const float *from = in + i * 2;
+            const float *to = in + (i + 1 < frames ? i + 1 : 0) * 2;
+            const float deltaX = to[0] - from[0];
+            const float deltaY = to[1] - from[1];
+
+            float *target = out + i * factor * 2;
+            for(unsigned int j = 0; j < factor * 2; j += 2){
+                target[j]     = from[0] + deltaX * weights[j];
+                target[j + 1] = from[1] + deltaY * weights[j + 1];
+            }
+        }
+    } //osclib_simd::upsample
+} //namespace osclib_simd
+
+//Fork-join pool used to draw big batches on more than one thread, the thread calling run() works too so a pool of n threads only starts n - 1 of them
+//Work gets split in chunks and every thread takes the next chunk from a shared counter as soon as it's done with the previous one,
+//so a thread that got short primitives ends up taking chunks the others would have drawn
+class oscWorkerPool {
+    public:
+        ~oscWorkerPool(){
+            stop();
+        }
+
+        bool start(unsigned int threads){ //Returns false if the threads couldn't be started, the pool then works on the caller's thread only
+            std::lock_guard<std::mutex> lock(busy);
+
+            stopWorkers();
+            if(threads <= 1)return true;
+
+            workers = new (std::nothrow) std::thread[threads - 1];
+            if(workers == nullptr)return false;
+
+            try {
+                for(; worker_count < threads - 1; worker_count++)workers[worker_count] = std::thread(&oscWorkerPool::workerLoop, this);
+            } catch(...){ //std::thread throws if the system can't start any more threads
+                stopWorkers();
+                return false;
+            }
+
+            return true;
+        } //oscWorkerPool::start
+
+        void stop(){
+            std::lock_guard<std::mutex> lock(busy);
+            stopWorkers();
+        } //oscWorkerPool::stop
+
+        unsigned int threads(){
+            return worker_count + 1;
+        } //oscWorkerPool::threads
+
+        //Calls work(context, chunk) once for every chunk from 0 to chunks - 1 spread over all the threads, returns once every chunk is done
+        //The pool runs one job at a time, if another instance of the library is using it this returns false straight away and the caller should do the work itself
+        bool run(void (*work)(void *context, unsigned int chunk), void *context, unsigned int chunks){
+            std::unique_lock<std::mutex> lock(busy, std::try_to_lock);
+            if(!lock.owns_lock())return false;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                job = work;
+                job_context = context;
+                job_chunks = chunks;
+                next_chunk.store(0, std::memory_order_relaxed);
+                workers_done.store(0, std::memory_order_relaxed);
+                generation++;
+            }
+            wake.notify_all();
+
+            runChunks(work, context, chunks);
+
+            //Every worker has to be done with this job before the next one can change it
+            while(workers_done.load(std::memory_order_acquire) < worker_count)std::this_thread::yield();
+            return true;
+        } //oscWorkerPool::run
+
+    private:
+        std::thread *workers = nullptr;
+        unsigned int worker_count = 0;
+
+        std::mutex busy; //Held while a job runs or while the threads get started or stopped
+
+        void stopWorkers(){
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                quitting = true;
+            }
+            wake.notify_all();
+
+            for(unsigned int i = 0; i < worker_count; i++)workers[i].join();
+            delete[] workers;
+
+            workers = nullptr;
+            worker_count = 0;
+            quitting = false;
+        } //oscWorkerPool::stopWorkers
+
+        std::mutex mutex; //Guards the job and generation, the workers sleep on wake between two jobs
+        std::condition_variable wake;
+        bool quitting = false;
+        unsigned long generation = 0; //Goes up by one at every run()
+
+        void (*job)(void *context, unsigned int chunk) = nullptr;
+        void *job_context = nullptr;
+        unsigned int job_chunks = 0;
+        std::atomic<unsigned int> next_chunk{0};
+        std::atomic<unsigned int> workers_done{0};
+
+        void runChunks(void (*work)(void *context, unsigned int chunk), void *context, unsigned int chunks){
+            for(unsigned int chunk = next_chunk.fetch_add(1, std::memory_order_relaxed); chunk < chunks; chunk = next_chunk.fetch_add(1, std::memory_order_relaxed)){
+                work(context, chunk);
+            }
+        } //oscWorkerPool::runChunks
+
+        void workerLoop(){
+            unsigned long seen = 0;
+
+            while(true){
+                void (*work)(void *context, unsigned int chunk);
+                void *context;
+                unsigned int chunks;
+
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wake.wait(lock, [&]{ return quitting || generation != seen; });
+                    if(quitting)return;
+
+                    seen = generation;
+                    work = job;
+                    context = job_context;
+                    chunks = job_chunks;
+                }
+
+                runChunks(work, context, chunks);
+                workers_done.fetch_add(1, std::memory_order_release);
+            }
+        } //oscWorkerPool::workerLoop
+}; //oscWorkerPool class
+
+static oscWorkerPool workerPool; //Started by set_threads(), it's shared by every instance of the library
+
+//portAudio has to be initialized once per process and terminated only once nobody uses it anymore
+//Every open stream holds a reference, the first one initializes portAudio and the last one to close terminates it
+class oscPortAudio {
+    public:
+        PaError acquire(){
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if(references == 0){
+                PaError error_output = Pa_Initialize();
+                if(error_output != paNoError)return error_output;
+            }
+
+            references++;
+            return paNoError;
+        } //oscPortAudio::acquire
+
+        void release(){
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if(references == 0)return;
+            if(--references == 0)Pa_Terminate();
+        } //oscPortAudio::release
+
+    private:
+        std::mutex mutex;
+        unsigned int references = 0;
+}; //oscPortAudio class
+
+static oscPortAudio portAudio; //Shared by every instance of the library
+
+//Bump allocator for the memory that's only needed while a batch gets drawn or a frame gets published (optimizer, sample budget, batch offsets)
+//Allocating is moving a pointer and reset() gives everything back at once in O(1), the memory is kept for the next time
+//If a frame needs more than what's reserved the extra memory gets its own block, at the next reset() those blocks are freed and the main block
+//grows to the most that was ever used at once, so after the first few frames (or after reserve()) it never allocates again
+class oscArena {
+    public:
+        ~oscArena(){
+            release();
+        }
+
+        bool reserve(size_t bytes){ //Makes the main block at least bytes big, everything allocated from the arena has to be given back with reset() first
+            if(bytes <= capacity)return true;
+            if(used > 0 || overflow != nullptr)return false;
+
+            bytes = (bytes + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE; //aligned_alloc wants the size to be a multiple of the alignment
+            char *block = (char*)OSCLIB_ALIGNED_ALLOC(CACHE_LINE_SIZE, bytes);
+            if(block == nullptr)return false;
+
+            OSCLIB_ALIGNED_FREE(memory);
+            memory = block;
+            capacity = bytes;
+            return true;
+        } //oscArena::reserve
+
+        template<typename type>
+        type *allocate(size_t count){ //Memory for count elements aligned to a cache line, nullptr if there's no memory left, nothing gets constructed
+            const size_t bytes = (count * sizeof(type) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+            high_water += bytes;
+
+            if(used + bytes <= capacity){
+                type *output = (type*)(memory + used);
+                used += bytes;
+                return output;
+            }
+
+            //Doesn't fit, the main block can't move since what was allocated from it is still being used
+            overflowBlock *block = (overflowBlock*)OSCLIB_ALIGNED_ALLOC(CACHE_LINE_SIZE, CACHE_LINE_SIZE + bytes);
+            if(block == nullptr)return nullptr;
+
+            block->next = overflow;
+            overflow = block;
+            return (type*)((char*)block + CACHE_LINE_SIZE);
+        } //oscArena::allocate
+
+        void reset(){
+            if(overflow != nullptr){ //Only happens while warming up
+                while(overflow != nullptr){
+                    overflowBlock *next = overflow->next;
+                    OSCLIB_ALIGNED_FREE(overflow);
+                    overflow = next;
+                }
+
+                used = 0;
+                reserve(high_water);
+            }
+
+            used = 0;
+            high_water = 0;
+        } //oscArena::reset
+
+        void release(){ //Gives all the memory back
+            reset();
+
+            OSCLIB_ALIGNED_FREE(memory);
+            memory = nullptr;
+            capacity = 0;
+        } //oscArena::release
+
+        size_t reserved(){
+            return capacity;
+        } //oscArena::reserved
+
+    private:
+        typedef struct overflowBlock {
+            overflowBlock *next;
+        } overflowBlock;
+
+        char *memory = nullptr;
+        size_t capacity = 0;
+        size_t used = 0;
+        size_t high_water = 0; //Bytes asked since the last reset(), overflow included
+        overflowBlock *overflow = nullptr; //Blocks allocated since the last reset() because the main block was full
+}; //oscArena class
 
 enum osclib_err : int { //define an enumerator for the errors that can happen during the code
     osc_no_err = 1,
 
-    audio_stream_ill_modif = 100
+    audio_stream_ill_modif = 100,
+    buffer_alloc_err = 101, //The frame couldn't grow because there was no memory left
+    file_write_err = 102,   //The output file couldn't be created or written
+    scene_object_err = 103, //There's no scene object with that id
+    scene_recording_err = 104, //Not allowed while drawing into a scene object, or scene_end() called without scene_begin()
+    thread_start_err = 105, //The worker threads couldn't be started
+    streaming_err = 106,    //Streaming already started (or not started) or its configuration doesn't make sense
+    transform_stack_err = 107, //push_transform() with a full stack or pop_transform() with an empty one
+    file_read_err = 108,    //The input file couldn't be opened or read
+    file_format_err = 109,  //The input file isn't in the format it should be
+    publish_busy_err = 110  //try_publish_frame() found the callback still playing the frame before the last published one
+};
+
+enum osclib_file_format : int { //Formats render_to_file() can write
+    osc_file_wav = 0, //32-bit float stereo WAV
+    osc_file_raw = 1  //Interleaved left/right 32-bit floats with no header
 };
 
 class oscilloscopeLibrary {
     public:
+        oscilloscopeLibrary();
+        ~oscilloscopeLibrary(); //Stops the stream if it's still running and gives all the memory back
+
+        //The audio stream keeps a pointer to the instance's frames so an instance can't be copied
+        oscilloscopeLibrary(const oscilloscopeLibrary&) = delete;
+        oscilloscopeLibrary &operator=(const oscilloscopeLibrary&) = delete;
+
         osclib_err draw_line(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2);
         osclib_err draw_point(unsigned int x, unsigned int y, unsigned short duration);
 
-        PaError open_start(unsigned int sample_rate = DEFAULT_SAMPLE_RATE);
+        //Batch versions of draw_line(), the frame grows only once for the whole batch and vertices shared by two lines are only drawn once
+        osclib_err draw_polyline(const oscPoint *points, unsigned int count); //Connects every point to the next one
+        osclib_err draw_polygon(const oscPoint *points, unsigned int count);  //Same as draw_polyline() but the last point gets connected back to the first one
+        osclib_err draw_segments(const oscSegment *segments, unsigned int count); //Draws separate lines, a segment starting where the previous one ended continues it without repeating the vertex
+
+        //Writes text with the built-in stroke font, x and y are the bottom left corner of the first character and scale is the size of a glyph unit (a glyph is 4 by 6 units)
+        //'\n' starts a new line below the first character
+        osclib_err draw_text(unsigned int x, unsigned int y, const char *text, float scale = 2.00f);
+
+        //Curves, their number of samples comes from their length on the screen times the density so a curve is as bright as a line of the same length
+        //Angles are in degrees, counterclockwise starting from the right
+        osclib_err draw_circle(unsigned int cx, unsigned int cy, unsigned int radius);
+        osclib_err draw_arc(unsigned int cx, unsigned int cy, unsigned int radius, float start_angle, float end_angle);
+        osclib_err draw_ellipse(unsigned int cx, unsigned int cy, unsigned int rx, unsigned int ry, float rotation = 0.00f);
+        osclib_err draw_bezier(oscPoint p0, oscPoint p1, oscPoint p2, oscPoint p3); //Cubic bezier going from p0 to p3, p1 and p2 are the control points
+
+        //Same as the functions above with fractional coordinates, they can also go outside of the screen and get brought back in by a transform
+        osclib_err draw_linef(float x1, float y1, float x2, float y2);
+        osclib_err draw_pointf(float x, float y, unsigned short duration);
+        osclib_err draw_polylinef(const oscPointF *points, unsigned int count, bool closed = false); //closed connects the last point back to the first one like draw_polygon()
+        osclib_err draw_ellipsef(float cx, float cy, float rx, float ry, float rotation = 0.00f);
+        osclib_err draw_bezierf(oscPointF p0, oscPointF p1, oscPointF p2, oscPointF p3);
+
+        //Transform stack, every draw_* call goes through the current transform (the identity at the start)
+        //The samples are transformed after they're drawn, every primitive drawn under the same transform gets transformed in one vectorized pass before the frame gets published
+        //Lines and curves get their number of samples from their transformed length so zooming doesn't change how bright they are, text and points keep theirs
+        //translate(), rotate() and scale() get applied before the current transform, like the transform attribute of SVG
+        osclib_err push_transform(); //Saves the current transform
+        osclib_err pop_transform();  //Goes back to the last saved one
+        void reset_transform();
+        void set_transform(const oscTransform &transform);
+        void apply_transform(const oscTransform &transform);
+        void translate(float x, float y);
+        void rotate(float degrees, float cx = 0.00f, float cy = 0.00f); //Counterclockwise around cx cy
+        void scale(float x, float y);
+        static oscTransform identity_transform();
+
+        void set_density(float samples_per_unit); //Samples per unit of length (0.01) for lines and curves, higher makes them brighter and slower to draw
+        float sample_density(); //What lines and curves actually get drawn with: the density divided by the oversampling, before the transform's zoom
+
+        //Appends frames samples that were already drawn (on the -1.00 to +1.00 scale) as one primitive, they go through the transform like everything else
+        osclib_err draw_samples(const float *left, const float *right, unsigned int frames);
+
+        //Draws at sample_rate / factor and lets publish_frame() bring the frame up to the sample rate by interpolating between the drawn samples
+        //Lines, curves, text and points get factor times less samples so they look the same, but drawing gets factor times cheaper and the beam moves smoothly on fast DACs
+        //Every sample of a published frame gets interpolated so it should be set before drawing, scene objects drawn before it changed have to be drawn again
+        //set_refresh_rate() budgets and frame_over_budget() are then counted in drawn samples, 1 (the default) turns it off and it can go up to MAX_OVERSAMPLING
+        void set_oversampling(unsigned int factor);
+
+        //Number of threads used to draw big batches (draw_polyline(), draw_polygon() and draw_segments()), 0 uses one per CPU core and 1 (the default) draws everything on the caller's thread
+        //Every line gets its position in the frame before any of them is drawn so the threads write straight into the frame and nothing has to be merged afterwards
+        osclib_err set_threads(unsigned int threads);
+        unsigned int thread_count(); //Threads the batches actually get drawn with, the caller's thread included
+
+        //When enabled publish_frame() reorders the primitives of the frame, and draws some of them backwards, so the beam jumps as little as possible between them
+        //Every draw_* call is one primitive, the frame takes a bit longer to publish but wastes less samples on jumps and shows less retrace lines
+        void set_optimize_order(bool enabled);
+
+        //Makes every published frame exactly sample_rate / frames_per_second samples long so the picture refreshes at a fixed rate whatever gets drawn
+        //The samples get shared between the primitives in proportion to how many samples they were drawn with, a frame that needed more than the budget
+        //gets squeezed into it and frame_over_budget() tells by how much, 0 turns the fixed budget off
+        //The sample rate is the one given to open_start() or to render_to_file(), DEFAULT_SAMPLE_RATE before either of them gets called
+        void set_refresh_rate(float frames_per_second);
+        unsigned int frame_over_budget(); //Samples the last published frame had over the budget, 0 if it fit (or if there's no budget)
+
+        //Hands the frame drawn so far to the audio stream and starts a new empty one, the callback picks it up once it finished playing the current frame so frames never get torn
+        //The new back frame is the one that was playing, drawing into it is fine but it can only be published again once the callback moved on to the frame published after it:
+        //if the next publish_frame() comes before that it blocks until the end of the playing frame, which can be a long time for long frames
+        osclib_err publish_frame();
+        osclib_err try_publish_frame(); //Same as publish_frame() but returns publish_busy_err instead of blocking, the frame is then left as it is and can be drawn into and published later
+
+        //Retained scene, objects are drawn once and then get added to every published frame after whatever was drawn straight into the frame
+        //Between scene_begin() and scene_end() every draw_* call goes into the object instead of the frame and replaces what the object had before,
+        //only the objects that get drawn again are rasterized again, the others are just copied into the frame
+        osclib_err scene_add(unsigned int *id); //Creates an empty visible object and writes its id into id
+        osclib_err scene_begin(unsigned int id);
+        osclib_err scene_end();
+        osclib_err scene_move(unsigned int id, int x, int y); //Draws the object moved by x and y units, without rasterizing it again
+        osclib_err scene_transform(unsigned int id, const oscTransform &transform); //Draws the object through transform (before moving it), rotating or zooming it is one pass over its samples
+        osclib_err scene_show(unsigned int id, bool visible);
+        osclib_err scene_remove(unsigned int id);
+        //Gives read access to what got drawn into an object, the pointers stay valid until the object gets drawn again or removed
+        osclib_err scene_samples(unsigned int id, const float **left, const float **right, unsigned int *frames, const paBlock **blocks, unsigned int *block_count);
+
+        //Makes both frames big enough to hold the requested number of samples and primitives so drawing and publishing don't need to allocate anything
+        //primitives also sizes the scratch memory used by set_optimize_order(), set_refresh_rate() and the batch functions (where every line of a batch counts as one)
+        //This is optional, without it the memory grows during the first frames and then stays the same
+        osclib_err reserve(unsigned int frames, unsigned int primitives = 0);
+        void clear(); //Throws away everything drawn into the back frame since the last publish_frame(), its memory is kept
+        void release(); //Same as clear() but also gives the memory of the back frame back, waiting like publish_frame() if the callback is still playing it
+        unsigned int frame_length(); //Number of samples drawn into the back frame so far
+
+        //If something was drawn before opening the stream it gets published first, if that fails the stream gets closed and the osclib_err is returned as the PaError
+        PaError open_start(unsigned int sample_rate = DEFAULT_SAMPLE_RATE, unsigned long frames_per_buffer = DEFAULT_FRAMES_PER_BUFFER);
         PaError stop_close();
 
+        //Same as open_start() with the device, host API, latency and period chosen explicitly
+        PaError open_stream(const oscStreamConfig &config);
+        static oscStreamConfig stream_config(); //The configuration open_start() uses, to change only some of it
+
+        //Writes up to capacity output devices (with at least two channels) into devices and how many there are in total into count, devices can be nullptr to only count them
+        static PaError list_devices(oscDeviceInfo *devices, unsigned int capacity, unsigned int *count);
+
+        double output_latency(); //Latency the host API actually gave to the open stream in seconds, 0 if no stream is open
+        double stream_sample_rate(); //Sample rate the host API actually gave to the open stream, 0 if no stream is open
+
+        //Streaming mode, for content that never repeats and can't be drawn as one looping frame
+        //The callback stops playing the published frames and plays whatever gets written into a ring instead, if producer is given a thread of the library
+        //keeps the ring between the watermarks by calling it, otherwise the application writes into the ring with stream_write() (from one thread only)
+        osclib_err start_streaming(const oscStreamingConfig &config, oscStreamProducer producer = nullptr, void *user_data = nullptr);
+        osclib_err stop_streaming(); //Goes back to playing the published frames, samples still in the ring get thrown away
+        static oscStreamingConfig streaming_config();
+        unsigned long stream_write(const float *samples, unsigned long frames); //Copies up to frames interleaved pairs into the ring without waiting and returns how many fit
+        unsigned long stream_fill(); //Pairs written into the ring and not played yet
+
+        //Counters kept by the audio callback, reading them never blocks it
+        void health(oscHealth *stats);
+        void reset_health();
+
+        //Offline output, these run the same callback as the audio stream without opening any device so they can only be used while the stream is stopped
+        //They play whatever got published last, as fast as the CPU allows, and carry on from where the previous call stopped
+        osclib_err render(float *output, unsigned long frames); //Writes frames interleaved left/right pairs into output
+        //sample_rate also becomes the rate set_refresh_rate() budgets for, the frame published last gets its budget worked out again if it changed
+        osclib_err render_to_file(const char *name, unsigned long frames, unsigned int sample_rate = DEFAULT_SAMPLE_RATE, osclib_file_format format = osc_file_wav);
+
     private:
         bool initialised = false;
-        bool buffer_initialised = false;
 
-		unsigned int buffer_size_old = 1;
-		unsigned int buffer_current_position = 1;
-
-        osclib_err updateBuffer();
+        paFrameSwap frame_swap = {}; //This instance's front and back frames, shared only with its own audio callback
+
+        paData *back_frame; //The frame every draw_* function writes into, it only gets played after publish_frame()
+        unsigned int other_frame_reserve = 0; //Capacity asked with reserve() while the other frame was being played
+        unsigned int other_frame_blocks = 0; //Same for the number of primitives
+
+        float density = DEFAULT_DENSITY; //Samples per unit of length, set with set_density()
+        unsigned int oversampling = 1; //Set with set_oversampling()
+        float draw_density = DEFAULT_DENSITY; //density / oversampling times the zoom of the transform, what lines and curves actually get drawn with
+
+        oscTransform transform = identity_transform(); //Current transform, changed by the transform functions
+        oscTransform transform_stack[TRANSFORM_STACK_DEPTH];
+        unsigned int transform_depth = 0;
+        unsigned int transform_start = 0; //Samples of the back frame from here on were drawn with the current transform and still have to go through it
+
+        unsigned long health_last_swaps = 0; //frames_swapped at the previous health() call
+        std::chrono::steady_clock::time_point health_last_time = std::chrono::steady_clock::now();
+
+        unsigned int sample_rate = DEFAULT_SAMPLE_RATE; //Of the stream, given to open_start()
+        const PaStreamInfo *stream_info = nullptr; //Latency and sample rate granted to the open stream, owned by portAudio
+        float refresh_rate = 0.00f; //Set with set_refresh_rate(), 0 if frames are as long as what got drawn
+        unsigned int over_budget = 0; //Returned by frame_over_budget()
+        unsigned int *block_budget = nullptr; //Samples every block of the frame being published gets out of the budget, taken from the scratch arena
+
+        sceneObject **scene_objects = nullptr; //Indexed by id - 1, removed objects leave a nullptr that scene_add() reuses
+        unsigned int scene_object_count = 0;
+        unsigned int scene_object_capacity = 0;
+        paData *scene_recording = nullptr; //The frame draw_* calls went into before scene_begin(), nullptr if no object is being drawn
+        paData scene_cache = {}; //Every visible object already moved and put one after the other, it's only built again when the scene changes
+        bool scene_dirty = false;
+
+        unsigned int *line_offsets = nullptr; //Where every line of a batch starts, relative to the start of the batch, with the batch's total at the end, taken from the scratch arena
+
+        oscArena scratch; //Memory only needed while a batch gets drawn or a frame gets published, it's reset at the start of both
+
+        paRing stream_ring = {}; //The ring given to the callback by start_streaming()
+        std::thread stream_producer; //Thread calling the producer function, not started if the application writes into the ring itself
+        std::atomic<bool> stream_stop{false};
+        std::atomic<unsigned int> stream_rate{DEFAULT_SAMPLE_RATE}; //Copy of sample_rate for the producer thread, the stream can get opened while it's running
+        oscStreamingConfig streaming = {};
+
+        bool optimize_order = false; //Set with set_optimize_order()
+        orderScratch order_scratch = {}; //Arrays used by the optimizer
+
+        osclib_err reserveFrame(paData *frame, unsigned int capacity);
+        osclib_err growBuffer(unsigned int frames, unsigned int *position);
+        osclib_err reserveBlocks(paData *frame, unsigned int count);
+        osclib_err reserveInterleaved(paData *frame, unsigned int capacity);
+        osclib_err spliceFrame(const paData *source, const oscTransform *matrix);
+        void flushTransform();
+        void transformChanged(); //Works out draw_density again
+        static bool isIdentity(const oscTransform &matrix);
+        static oscTransform multiplyTransform(const oscTransform &first, const oscTransform &second);
+        osclib_err composeScene();
+        bool backFrameFree(); //True if the callback doesn't read the back frame anymore
+        osclib_err publishBackFrame();
+        sceneObject *sceneObjectOf(unsigned int id);
+        osclib_err interleaveFrame(paData *frame);
+        osclib_err orderFrame(paData *frame);
+        osclib_err budgetFrame(paData *frame, unsigned int budget);
+        void resampleBlock(const float *left, const float *right, unsigned int frames, float *output, unsigned int output_frames, bool reversed);
+        unsigned int nearestBlock(float x, float y, bool *flip);
+        float blockDistance(unsigned int from, bool from_flipped, unsigned int to, bool to_flipped);
+
+        template<typename lineOf>
+        osclib_err rasterBatch(unsigned int count, lineOf line);
+
+        unsigned int lineSteps(oscPointF start, oscPointF end);
+        void rasterLine(unsigned int position, oscPointF start, oscPointF end, unsigned int steps);
+        void rasterEnd(unsigned int position, oscPointF end);
+
+        unsigned int curveSteps(float length);
+        osclib_err rasterEllipse(float cx, float cy, float rx, float ry, float rotation, float start_angle, float sweep, float length);
+
+        static osclib_err compileFont();
+        static unsigned int compileGlyph(const char *strokes, float *x, float *y);
+        void freeFrame(paData *frame);
+
+        bool writeFile(int file, const void *data, size_t bytes);
+
+        void producerLoop(oscStreamProducer producer, void *user_data);
+
+        static void drainRing(paRing *ring, float *output, unsigned long frames, paHealth &health){ //Plays frames pairs out of the ring, holding the last pair if there aren't enough
+            const unsigned long read = ring->read.load(std::memory_order_relaxed); //Only the callback moves it
+            unsigned long available = ring->write.load(std::memory_order_acquire) - read;
+            if(available > frames)available = frames;
+
+            //At most two copies, up to the end of the ring and then from its start
+            const unsigned long start = read & ring->mask;
+            const unsigned long first = (available < ring->mask + 1 - start ? available : ring->mask + 1 - start);
+            memcpy(output, ring->samples + start * 2, first * 2 * sizeof(float));
+            memcpy(output + first * 2, ring->samples, (available - first) * 2 * sizeof(float));
+
+            if(available > 0){
+                ring->hold_left = output[available * 2 - 2];
+                ring->hold_right = output[available * 2 - 1];
+            }
+            ring->read.store(read + available, std::memory_order_release); //Giving the space back to the producer
+
+            if(available < frames){
+                health.stream_underruns.fetch_add(1, std::memory_order_relaxed);
+                for(unsigned long i = available; i < frames; i++){
+                    output[i * 2] = ring->hold_left;
+                    output[i * 2 + 1] = ring->hold_right;
+                }
+            }
+        } //oscilloscopeLibrary::drainRing
 
         PaStream *audio_stream;
         static int paCallBack(
@@ -47,202 +1046,1869 @@ class oscilloscopeLibrary {
             PaStreamCallbackFlags flags,
             void *userData )
         {
+            const std::chrono::steady_clock::time_point callbackStart = std::chrono::steady_clock::now(); //Doesn't make a syscall on linux
+
             (void) inputBuffer; //Calling the inputbuffer like this so we don't get any unused variable warnings
             float *output = (float*)outputBuffer; //Casting outputBuffer from void to float pointer then storing it in *output
-            paData *preBufData = (paData*)userData; //Casting the userData from void to paTestData to store it into the *data pointer
+            paFrameSwap *frameSwap = (paFrameSwap*)userData; //Casting the userData from void to paFrameSwap to get both the frames
+            paHealth &health = frameSwap->health;
+
+            health.callbacks.fetch_add(1, std::memory_order_relaxed);
+            if(flags & paOutputUnderflow)health.output_underflows.fetch_add(1, std::memory_order_relaxed);
+            if(flags & paOutputOverflow)health.output_overflows.fetch_add(1, std::memory_order_relaxed);
+            if(flags & paPrimingOutput)health.priming.fetch_add(1, std::memory_order_relaxed);
+
+            //Jitter: two callbacks in a row should be played exactly the previous buffer's length apart
+            //render() passes no timeInfo and some host APIs leave the DAC time at 0, then there's nothing to measure
+            const double dacTime = (timeInfo != nullptr ? timeInfo->outputBufferDacTime : 0.00);
+            if(dacTime > 0.00 && health.last_dac_time > 0.00 && frameSwap->sample_rate > 0){
+                double jitter = (dacTime - health.last_dac_time) - (double)health.last_frames / frameSwap->sample_rate;
+                if(jitter < 0.00)jitter = -jitter;
+
+                const unsigned long jitterNs = (unsigned long)(jitter * 1e9);
+                health.jitter_count.fetch_add(1, std::memory_order_relaxed);
+                health.jitter_total.fetch_add(jitterNs, std::memory_order_relaxed);
+                if(jitterNs > health.jitter_max.load(std::memory_order_relaxed))health.jitter_max.store(jitterNs, std::memory_order_relaxed); //Only the callback writes it
+            }
+            health.last_dac_time = dacTime;
+            health.last_frames = framesPerBuffer;
+
+            //In streaming mode the ring replaces the frames, they're left where they are and picked up again once streaming stops
+            paRing *ring = frameSwap->stream.load(std::memory_order_acquire);
+            frameSwap->stream_reading.store(ring, std::memory_order_release);
+            if(ring != nullptr){
+                drainRing(ring, output, framesPerBuffer, health);
+                output += framesPerBuffer * 2;
+            }
 
-            for(unsigned int i = 0; i < preBufData->buffer_frames; i++){ //Passing all the data contained into the struct to the outputBuffer of portAudio
-                *output++ = *(preBufData->left_channel + i);
-                *output++ = *(preBufData->right_channel + i);
+            //The frame being played and the position inside of it are kept between callbacks, so every callback only writes the framesPerBuffer samples portAudio asked for
+            //and the latency stays the same however big the drawn frame is
+            paData *frame = frameSwap->playing.load(std::memory_order_acquire);
+            unsigned long cursor = (frame == frameSwap->cursor_frame ? frameSwap->cursor : 0);
+
+            unsigned long written = (ring != nullptr ? framesPerBuffer : 0);
+            while(written < framesPerBuffer){
+                if(frame == nullptr || cursor >= frame->interleaved_frames){
+                    //The cursor reached the end of the frame, this is the only place where the callback picks up the last published frame so a frame never gets torn
+                    //No locks and no allocations here, just two atomic operations
+                    frame = frameSwap->front.load(std::memory_order_acquire);
+                    frameSwap->playing.store(frame, std::memory_order_release); //Telling the application that the other frame is not being read anymore
+                    cursor = 0;
+
+                    if(frame != nullptr && frame != health.last_played){
+                        health.swaps.fetch_add(1, std::memory_order_relaxed);
+                        health.last_played = frame;
+                    }
+
+                    if(frame == nullptr || frame->interleaved_frames == 0){ //If nothing got published yet keep the beam in the center for the rest of the buffer
+                        for(; written < framesPerBuffer; written++){
+                            *output++ = 0.00f;
+                            *output++ = 0.00f;
+                        }
+                        break;
+                    }
+                }
+
+                //Copying as much of the frame as fits in what's left of the buffer, then wrapping around to the start of the frame
+                //The frame is already interleaved so this is a single block copy
+                unsigned long chunk = framesPerBuffer - written;
+                if(chunk > frame->interleaved_frames - cursor)chunk = frame->interleaved_frames - cursor;
+
+                memcpy(output, frame->interleaved + cursor * 2, chunk * 2 * sizeof(float));
+                output += chunk * 2;
+
+                cursor += chunk;
+                written += chunk;
             }
 
+            frameSwap->cursor = cursor;
+            frameSwap->cursor_frame = frame;
+
+            const unsigned long timeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - callbackStart).count();
+            unsigned int bucket = 0;
+            for(unsigned long us = timeNs / 1000; us > 0 && bucket < HEALTH_HISTOGRAM_BUCKETS - 1; us >>= 1)bucket++;
+
+            health.time_histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+            health.time_total.fetch_add(timeNs, std::memory_order_relaxed);
+            if(timeNs > health.time_max.load(std::memory_order_relaxed))health.time_max.store(timeNs, std::memory_order_relaxed);
+
             return 0; //We need to return an int since this function is defined to be an integer in portAudio
         } //oscilloscopeLibrary::paCallBack
-
-        float absolute(float input);
 }; //oscilloscopeLibrary class
 
-PaError oscilloscopeLibrary::open_start(unsigned int sample_rate){ //Initializes portAudio (if not already), opens a new stream with the requested settings and starts the playback
+oscilloscopeLibrary::oscilloscopeLibrary(){
+    back_frame = &frame_swap.frames[0]; //Starting to draw into the first frame, the second one becomes the back frame after the first publish_frame()
+} //oscilloscopeLibrary::oscilloscopeLibrary
+
+oscilloscopeLibrary::~oscilloscopeLibrary(){
+    if(frame_swap.stream.load(std::memory_order_relaxed) != nullptr)stop_streaming();
+    if(initialised)stop_close();
+    if(scene_recording != nullptr)scene_end();
+
+    freeFrame(&frame_swap.frames[0]);
+    freeFrame(&frame_swap.frames[1]);
+
+    for(unsigned int i = 0; i < scene_object_count; i++){
+        if(scene_objects[i] == nullptr)continue;
+
+        freeFrame(&scene_objects[i]->samples);
+        delete scene_objects[i];
+    }
+    delete[] scene_objects;
+    freeFrame(&scene_cache);
+} //oscilloscopeLibrary::~oscilloscopeLibrary
+
+void oscilloscopeLibrary::freeFrame(paData *frame){ //Gives the memory of a frame back, the frame can still be drawn into afterwards
+    delete[] frame->left_channel;
+    delete[] frame->right_channel;
+
+    OSCLIB_ALIGNED_FREE(frame->interleaved);
+
+    delete[] frame->blocks;
+
+    frame->left_channel = nullptr;
+    frame->right_channel = nullptr;
+    frame->interleaved = nullptr;
+    frame->blocks = nullptr;
+
+    frame->buffer_frames = 0;
+    frame->buffer_capacity = 0;
+    frame->interleaved_capacity = 0;
+    frame->interleaved_frames = 0;
+    frame->block_count = 0;
+    frame->block_capacity = 0;
+} //oscilloscopeLibrary::freeFrame
+
+osclib_err oscilloscopeLibrary::reserveFrame(paData *frame, unsigned int capacity){ //Makes a frame able to hold at least capacity samples keeping what was already drawn into it
+    if(capacity <= frame->buffer_capacity)return osc_no_err; //Nothing to do if the frame is already big enough
+
+    float *left  = new (std::nothrow) float[capacity];
+    float *right = new (std::nothrow) float[capacity];
+    if(left == nullptr || right == nullptr){ //Leave the frame as it was if we ran out of memory
+        delete[] left;
+        delete[] right;
+        return buffer_alloc_err;
+    }
+
+    //Only the samples drawn so far get copied, not the whole capacity
+    if(frame->buffer_frames > 0){
+        memcpy(left,  frame->left_channel,  frame->buffer_frames * sizeof(float));
+        memcpy(right, frame->right_channel, frame->buffer_frames * sizeof(float));
+    }
+
+    delete[] frame->left_channel;
+    delete[] frame->right_channel;
+
+    frame->left_channel = left;
+    frame->right_channel = right;
+    frame->buffer_capacity = capacity;
+
+    return osc_no_err;
+} //oscilloscopeLibrary::reserveFrame
+
+osclib_err oscilloscopeLibrary::growBuffer(unsigned int frames, unsigned int *position){ //Appends frames samples to the back frame and returns in position where the caller should start writing them
+    unsigned int needed = back_frame->buffer_frames + frames;
+
+    if(needed > back_frame->buffer_capacity){
+        //Growing geometrically so that drawing N primitives only copies the frame O(log N) times instead of at every primitive
+        unsigned int capacity = back_frame->buffer_capacity * 2;
+        if(capacity < 256)capacity = 256;
+        if(capacity < needed)capacity = needed;
+
+        OSC_TRACE(OSC_TRACE_DEBUG, "growing buffer to capacity", capacity);
+
+        osclib_err error_output = reserveFrame(back_frame, capacity);
+        if(error_output != osc_no_err)return error_output;
+    }
+
+    //Every call is one primitive, remembering where it is so the optimizer can move it around
+    if(frames > 0){
+        osclib_err error_output = reserveBlocks(back_frame, back_frame->block_count + 1);
+        if(error_output != osc_no_err)return error_output;
+
+        back_frame->blocks[back_frame->block_count].start = back_frame->buffer_frames;
+        back_frame->blocks[back_frame->block_count].length = frames;
+        back_frame->block_count++;
+    }
+
+    *position = back_frame->buffer_frames;
+    back_frame->buffer_frames = needed;
+
+    return osc_no_err;
+} //oscilloscopeLibrary::growBuffer
+
+osclib_err oscilloscopeLibrary::reserveBlocks(paData *frame, unsigned int count){ //Makes the block list of a frame able to hold count blocks
+    if(count <= frame->block_capacity)return osc_no_err;
+
+    unsigned int capacity = (frame->block_capacity < 64 ? 64 : frame->block_capacity * 2);
+    if(capacity < count)capacity = count;
+
+    paBlock *blocks = new (std::nothrow) paBlock[capacity];
+    if(blocks == nullptr)return buffer_alloc_err;
+
+    if(frame->block_count > 0)memcpy(blocks, frame->blocks, frame->block_count * sizeof(paBlock));
+    delete[] frame->blocks;
+
+    frame->blocks = blocks;
+    frame->block_capacity = capacity;
+
+    return osc_no_err;
+} //oscilloscopeLibrary::reserveBlocks
+
+osclib_err oscilloscopeLibrary::reserveInterleaved(paData *frame, unsigned int capacity){ //Makes the interleaved copy of a frame able to hold capacity stereo pairs keeping what it had, render() could still be playing it
+    if(capacity <= frame->interleaved_capacity)return osc_no_err;
+
+    //aligned_alloc wants the size to be a multiple of the alignment
+    size_t bytes = (size_t)capacity * 2 * sizeof(float);
+    bytes = (bytes + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+
+    float *interleaved = (float*)OSCLIB_ALIGNED_ALLOC(CACHE_LINE_SIZE, bytes);
+    if(interleaved == nullptr)return buffer_alloc_err;
+
+    if(frame->interleaved_frames > 0)memcpy(interleaved, frame->interleaved, frame->interleaved_frames * 2 * sizeof(float));
+    OSCLIB_ALIGNED_FREE(frame->interleaved);
+
+    frame->interleaved = interleaved;
+    frame->interleaved_capacity = capacity;
+
+    return osc_no_err;
+} //oscilloscopeLibrary::reserveInterleaved
+
+//Appends the samples and the blocks of source to the back frame through matrix, with a block copy if there is no matrix
+osclib_err oscilloscopeLibrary::spliceFrame(const paData *source, const oscTransform *matrix){
+    if(source->buffer_frames == 0)return osc_no_err;
+
+    unsigned int position;
+    osclib_err error_output = growBuffer(source->buffer_frames, &position);
+    if(error_output != osc_no_err)return error_output;
+    back_frame->block_count--; //growBuffer() recorded the whole splice as one block, the blocks of source replace it so the optimizer can still move them one by one
+
+    error_output = reserveBlocks(back_frame, back_frame->block_count + source->block_count);
+    if(error_output != osc_no_err)return error_output;
+
+    for(unsigned int i = 0; i < source->block_count; i++){
+        back_frame->blocks[back_frame->block_count].start = source->blocks[i].start + position;
+        back_frame->blocks[back_frame->block_count].length = source->blocks[i].length;
+        back_frame->block_count++;
+    }
+
+    if(matrix == nullptr){
+        memcpy(back_frame->left_channel + position,  source->left_channel,  source->buffer_frames * sizeof(float));
+        memcpy(back_frame->right_channel + position, source->right_channel, source->buffer_frames * sizeof(float));
+    } else {
+        //The matrix is in the 0 to 200 units and the samples go from -1.00 to +1.00, only the translation changes: x' = a x + c y + (a + c + e / 100 - 1)
+        const float sampleMatrix[6] = {matrix->a, matrix->b, matrix->c, matrix->d, matrix->a + matrix->c + matrix->e * 0.01f - 1.00f, matrix->b + matrix->d + matrix->f * 0.01f - 1.00f};
+        osclib_simd::affine(source->left_channel, source->right_channel, back_frame->left_channel + position, back_frame->right_channel + position, source->buffer_frames, sampleMatrix);
+    }
+
+    return osc_no_err;
+} //oscilloscopeLibrary::spliceFrame
+
+osclib_err oscilloscopeLibrary::composeScene(){ //Appends every visible scene object to the back frame, building the scene cache again first if something changed
+    if(scene_dirty){
+        OSC_TRACE(OSC_TRACE_DEBUG, "composeScene: rebuilding scene cache, objects =", scene_object_count);
+
+        paData *frame = back_frame;
+        back_frame = &scene_cache; //Drawing the objects into the cache with the same functions used to draw into the frame
+        back_frame->buffer_frames = 0;
+        back_frame->block_count = 0;
+
+        osclib_err error_output = osc_no_err;
+        for(unsigned int i = 0; i < scene_object_count && error_output == osc_no_err; i++){
+            if(scene_objects[i] == nullptr || !scene_objects[i]->visible)continue;
+
+            //Moving after the object's own transform
+            oscTransform matrix = identity_transform();
+            matrix.e = scene_objects[i]->x;
+            matrix.f = scene_objects[i]->y;
+            matrix = multiplyTransform(matrix, scene_objects[i]->transform);
+
+            error_output = spliceFrame(&scene_objects[i]->samples, (isIdentity(matrix) ? nullptr : &matrix));
+        }
+
+        back_frame = frame;
+        if(error_output != osc_no_err)return error_output;
+
+        scene_dirty = false;
+    }
+
+    return spliceFrame(&scene_cache, nullptr);
+} //oscilloscopeLibrary::composeScene
+
+sceneObject *oscilloscopeLibrary::sceneObjectOf(unsigned int id){ //nullptr if there's no object with that id
+    if(id == 0 || id > scene_object_count)return nullptr;
+    return scene_objects[id - 1];
+} //oscilloscopeLibrary::sceneObjectOf
+
+osclib_err oscilloscopeLibrary::scene_transform(unsigned int id, const oscTransform &transform){
+    sceneObject *object = sceneObjectOf(id);
+    if(object == nullptr)return scene_object_err;
+
+    object->transform = transform;
+    scene_dirty = true;
+
+    return osc_no_err;
+} //oscilloscopeLibrary::scene_transform
+
+osclib_err oscilloscopeLibrary::scene_add(unsigned int *id){
+    unsigned int index = 0;
+    while(index < scene_object_count && scene_objects[index] != nullptr)index++; //Reusing the slot of a removed object if there's one
+
+    if(index == scene_object_capacity){
+        unsigned int capacity = (scene_object_capacity < 16 ? 16 : scene_object_capacity * 2);
+
+        sceneObject **objects = new (std::nothrow) sceneObject*[capacity];
+        if(objects == nullptr)return buffer_alloc_err;
+
+        if(scene_object_count > 0)memcpy(objects, scene_objects, scene_object_count * sizeof(sceneObject*));
+        delete[] scene_objects;
+
+        scene_objects = objects;
+        scene_object_capacity = capacity;
+    }
+
+    sceneObject *object = new (std::nothrow) sceneObject();
+    if(object == nullptr)return buffer_alloc_err;
+    object->visible = true;
+    object->transform = identity_transform();
+
+    scene_objects[index] = object;
+    if(index == scene_object_count)scene_object_count++;
+
+    *id = index + 1; //0 is never a valid id
+    return osc_no_err;
+} //oscilloscopeLibrary::scene_add
+
+osclib_err oscilloscopeLibrary::scene_begin(unsigned int id){
+    if(scene_recording != nullptr)return scene_recording_err;
+
+    sceneObject *object = sceneObjectOf(id);
+    if(object == nullptr)return scene_object_err;
+
+    //Whatever the object had gets replaced, its memory is kept
+    object->samples.buffer_frames = 0;
+    object->samples.block_count = 0;
+
+    flushTransform();
+    scene_recording = back_frame;
+    back_frame = &object->samples;
+    transform_start = 0;
+    scene_dirty = true;
+
+    return osc_no_err;
+} //oscilloscopeLibrary::scene_begin
+
+osclib_err oscilloscopeLibrary::scene_end(){
+    if(scene_recording == nullptr)return scene_recording_err;
+
+    flushTransform();
+    back_frame = scene_recording;
+    scene_recording = nullptr;
+    transform_start = back_frame->buffer_frames; //It went through the transform at scene_begin()
+
+    return osc_no_err;
+} //oscilloscopeLibrary::scene_end
+
+osclib_err oscilloscopeLibrary::scene_move(unsigned int id, int x, int y){
+    sceneObject *object = sceneObjectOf(id);
+    if(object == nullptr)return scene_object_err;
+
+    if(object->x != x || object->y != y)scene_dirty = true;
+    object->x = x;
+    object->y = y;
+
+    return osc_no_err;
+} //oscilloscopeLibrary::scene_move
+
+osclib_err oscilloscopeLibrary::scene_show(unsigned int id, bool visible){
+    sceneObject *object = sceneObjectOf(id);
+    if(object == nullptr)return scene_object_err;
+
+    if(object->visible != visible)scene_dirty = true;
+    object->visible = visible;
+
+    return osc_no_err;
+} //oscilloscopeLibrary::scene_show
+
+osclib_err oscilloscopeLibrary::scene_samples(unsigned int id, const float **left, const float **right, unsigned int *frames, const paBlock **blocks, unsigned int *block_count){
+    sceneObject *object = sceneObjectOf(id);
+    if(object == nullptr)return scene_object_err;
+    if(back_frame == &object->samples)return scene_recording_err; //Its samples haven't gone through the transform yet
+
+    *left = object->samples.left_channel;
+    *right = object->samples.right_channel;
+    *frames = object->samples.buffer_frames;
+    *blocks = object->samples.blocks;
+    *block_count = object->samples.block_count;
+
+    return osc_no_err;
+} //oscilloscopeLibrary::scene_samples
+
+osclib_err oscilloscopeLibrary::scene_remove(unsigned int id){
+    sceneObject *object = sceneObjectOf(id);
+    if(object == nullptr)return scene_object_err;
+    if(scene_recording != nullptr && back_frame == &object->samples)return scene_recording_err; //It's being drawn into
+
+    freeFrame(&object->samples);
+    delete object;
+
+    scene_objects[id - 1] = nullptr;
+    scene_dirty = true;
+
+    return osc_no_err;
+} //oscilloscopeLibrary::scene_remove
+
+osclib_err oscilloscopeLibrary::interleaveFrame(paData *frame){ //Fills the interleaved copy of a frame, this is done once per frame on the application thread and not in the callback
+    scratch.reset(); //Nothing allocated from it before is used anymore
+    //With a refresh rate the frame gets stretched or squeezed to the sample budget, otherwise it's as long as what got drawn
+    unsigned int budget = 0;
+    if(refresh_rate >= MIN_REFRESH_RATE && frame->buffer_frames > 0)budget = (unsigned int)(sample_rate / refresh_rate / oversampling); //In drawn samples, every one of them becomes oversampling samples of the stream
+
+    const unsigned int output_frames = (budget > 0 ? budget : frame->buffer_frames);
+    over_budget = (budget > 0 && frame->buffer_frames > budget ? frame->buffer_frames - budget : 0);
+    if(over_budget > 0)OSC_TRACE(OSC_TRACE_INFO, "interleaveFrame: frame over budget, samples drawn, budget =", frame->buffer_frames, budget);
+
+    osclib_err error_output = reserveInterleaved(frame, (output_frames > frame->buffer_capacity ? output_frames : frame->buffer_capacity) * oversampling);
+    if(error_output != osc_no_err)return error_output;
+    frame->interleaved_frames = output_frames * oversampling;
+
+    //With oversampling the frame first gets put together at the drawing rate in the scratch arena and then interpolated into the interleaved frame
+    float *output = frame->interleaved;
+    if(oversampling > 1){
+        output = scratch.allocate<float>((size_t)output_frames * 2);
+        if(output == nullptr)return buffer_alloc_err;
+    }
+    float *const output_start = output;
+
+    const bool reorder = (optimize_order && frame->block_count >= 3); //With less than 3 primitives there's no order better than the other
+    if(!reorder && budget == 0){
+        osclib_simd::interleave(frame->left_channel, frame->right_channel, output, frame->buffer_frames);
+        if(oversampling > 1)osclib_simd::upsample(output_start, frame->interleaved, output_frames, oversampling);
+        return osc_no_err;
+    }
+
+    if(reorder){
+        error_output = orderFrame(frame);
+        if(error_output != osc_no_err)return error_output;
+    }
+    if(budget > 0){
+        error_output = budgetFrame(frame, budget);
+        if(error_output != osc_no_err)return error_output;
+    }
+
+    //Writing the primitives one by one, in the optimized order and with the flipped ones backwards if the order got optimized
+    for(unsigned int i = 0; i < frame->block_count; i++){
+        const unsigned int index = (reorder ? order_scratch.order[i] : i);
+        const bool reversed = (reorder && order_scratch.flipped[index]);
+        const paBlock &block = frame->blocks[index];
+
+        if(budget > 0){
+            resampleBlock(frame->left_channel + block.start, frame->right_channel + block.start, block.length, output, block_budget[index], reversed);
+            output += block_budget[index] * 2;
+        } else {
+            if(reversed)osclib_simd::interleaveReversed(frame->left_channel + block.start, frame->right_channel + block.start, output, block.length);
+            else osclib_simd::interleave(frame->left_channel + block.start, frame->right_channel + block.start, output, block.length);
+
+            output += block.length * 2;
+        }
+    }
+
+    if(oversampling > 1)osclib_simd::upsample(output_start, frame->interleaved, output_frames, oversampling);
+
+    return osc_no_err;
+} //oscilloscopeLibrary::interleaveFrame
+
+//Shares budget samples between the blocks of the frame in proportion to their length, rounding the running total so the lengths add up to exactly budget
+//If the budget is smaller than the number of blocks the shortest ones can end up with no samples at all
+osclib_err oscilloscopeLibrary::budgetFrame(paData *frame, unsigned int budget){
+    block_budget = scratch.allocate<unsigned int>(frame->block_count);
+    if(block_budget == nullptr)return buffer_alloc_err;
+
+    unsigned long long drawn = 0; //Samples drawn up to the current block
+    unsigned int given = 0; //Samples of the budget given out up to the current block
+    for(unsigned int i = 0; i < frame->block_count; i++){
+        drawn += frame->blocks[i].length;
+
+        const unsigned int total = (unsigned int)(drawn * budget / frame->buffer_frames);
+        block_budget[i] = total - given;
+        given = total;
+    }
+
+    return osc_no_err;
+} //oscilloscopeLibrary::budgetFrame
+
+//Writes a block of frames samples as output_frames interleaved samples, interpolating linearly between the original ones so the beam keeps the same path
+void oscilloscopeLibrary::resampleBlock(const float *left, const float *right, unsigned int frames, float *output, unsigned int output_frames, bool reversed){
+    if(output_frames == frames){ //Nothing to resample
+        if(reversed)osclib_simd::interleaveReversed(left, right, output, frames);
+        else osclib_simd::interleave(left, right, output, frames);
+        return;
+    }
+
+    const double step = (double)frames / output_frames; //Samples are spread over the same span the block had, its end is still excluded like in rasterLine()
+
+    for(unsigned int i = 0; i < output_frames; i++){
+        const double position = i * step;
+        unsigned int sample = (unsigned int)position;
+        float fraction = (float)(position - sample);
+
+        if(sample + 1 >= frames){ //Past the last sample there's nothing to interpolate with
+            sample = frames - 1;
+            fraction = 0.00f;
+        }
+
+        const float x = left[sample] + (left[sample + (fraction > 0.00f)] - left[sample]) * fraction;
+        const float y = right[sample] + (right[sample + (fraction > 0.00f)] - right[sample]) * fraction;
+
+        const unsigned int target = (reversed ? output_frames - 1 - i : i);
+        output[target * 2]     = x;
+        output[target * 2 + 1] = y;
+    }
+} //oscilloscopeLibrary::resampleBlock
+
+void oscilloscopeLibrary::set_refresh_rate(float frames_per_second){
+    refresh_rate = (frames_per_second >= MIN_REFRESH_RATE ? frames_per_second : 0.00f);
+} //oscilloscopeLibrary::set_refresh_rate
+
+unsigned int oscilloscopeLibrary::frame_over_budget(){
+    return over_budget;
+} //oscilloscopeLibrary::frame_over_budget
+
+void oscilloscopeLibrary::set_optimize_order(bool enabled){
+    optimize_order = enabled;
+} //oscilloscopeLibrary::set_optimize_order
+
+//Distance the beam jumps going from the block from to the block to, a flipped block starts from its last sample and ends on its first one
+float oscilloscopeLibrary::blockDistance(unsigned int from, bool from_flipped, unsigned int to, bool to_flipped){
+    const float *exit = order_scratch.ends + from * 4 + (from_flipped ? 0 : 2);
+    const float *entry = order_scratch.ends + to * 4 + (to_flipped ? 2 : 0);
+
+    const float distanceX = entry[0] - exit[0];
+    const float distanceY = entry[1] - exit[1];
+
+    return std::sqrt(distanceX * distanceX + distanceY * distanceY);
+} //oscilloscopeLibrary::blockDistance
+
+//Finds the block not visited yet with an end closest to x and y, flip tells whether the beam should enter it from its last sample
+//The grid is searched in rings of cells around x and y, stopping once no cell further away can have anything closer than what was found
+unsigned int oscilloscopeLibrary::nearestBlock(float x, float y, bool *flip){
+    const int gridSize = order_scratch.grid_size;
+    const float cellSize = 2.00f / gridSize;
+
+    int cellX = (int)((x + 1.00f) / cellSize);
+    int cellY = (int)((y + 1.00f) / cellSize);
+    cellX = (cellX < 0 ? 0 : (cellX >= gridSize ? gridSize - 1 : cellX));
+    cellY = (cellY < 0 ? 0 : (cellY >= gridSize ? gridSize - 1 : cellY));
+
+    unsigned int best = 0;
+    float bestDistance = -1.00f;
+
+    for(int ring = 0; ring < gridSize; ring++){
+        for(int gridY = cellY - ring; gridY <= cellY + ring; gridY++){
+            if(gridY < 0 || gridY >= gridSize)continue;
+
+            //Only the cells on the ring, the inner ones were already searched: the whole row on the top and bottom side, the two ends of the row otherwise
+            const int stepX = (gridY == cellY - ring || gridY == cellY + ring ? 1 : 2 * ring);
+
+            for(int gridX = cellX - ring; gridX <= cellX + ring; gridX += stepX){
+                if(gridX < 0 || gridX >= gridSize)continue;
+
+                const unsigned int cell = gridY * gridSize + gridX;
+                unsigned int item = order_scratch.cell_start[cell];
+                while(item < order_scratch.cell_end[cell]){
+                    const unsigned int end = order_scratch.cell_items[item];
+
+                    if(order_scratch.visited[end / 2]){ //Swapping it with the cell's last item so the next searches don't look at it again
+                        order_scratch.cell_end[cell]--;
+                        order_scratch.cell_items[item] = order_scratch.cell_items[order_scratch.cell_end[cell]];
+                        continue;
+                    }
+
+                    const float distanceX = order_scratch.ends[end * 2] - x;
+                    const float distanceY = order_scratch.ends[end * 2 + 1] - y;
+                    const float distance = distanceX * distanceX + distanceY * distanceY;
+
+                    if(bestDistance < 0.00f || distance < bestDistance){
+                        bestDistance = distance;
+                        best = end / 2;
+                        *flip = (end % 2 == 1);
+                    }
+
+                    item++;
+                }
+            }
+        }
+
+        //Anything in the next ring is at least ring cells away
+        if(bestDistance >= 0.00f && bestDistance <= (ring * cellSize) * (ring * cellSize))break;
+    }
+
+    return best;
+} //oscilloscopeLibrary::nearestBlock
+
+osclib_err oscilloscopeLibrary::orderFrame(paData *frame){ //Fills order_scratch with the order and the direction the blocks of the frame should be drawn in
+    const unsigned int blocks = frame->block_count;
+
+    order_scratch.order = scratch.allocate<unsigned int>(blocks);
+    order_scratch.flipped = scratch.allocate<unsigned char>(blocks);
+    order_scratch.visited = scratch.allocate<unsigned char>(blocks);
+    order_scratch.ends = scratch.allocate<float>(blocks * 4);
+    order_scratch.jumps = scratch.allocate<float>(blocks);
+    order_scratch.cell_items = scratch.allocate<unsigned int>(blocks * 2);
+
+    if(order_scratch.order == nullptr || order_scratch.flipped == nullptr || order_scratch.visited == nullptr || order_scratch.ends == nullptr || order_scratch.jumps == nullptr || order_scratch.cell_items == nullptr){
+        return buffer_alloc_err;
+    }
+
+    //Sorting both ends of every block into the grid cells (counting sort)
+    //Around one block per cell
+    int gridSize = (int)std::sqrt((float)blocks);
+    gridSize = (gridSize < 1 ? 1 : (gridSize > ORDER_GRID_SIZE ? ORDER_GRID_SIZE : gridSize));
+    order_scratch.grid_size = gridSize;
+
+    const unsigned int cells = gridSize * gridSize;
+    const float cellSize = 2.00f / gridSize;
+    auto cellOf = [&](unsigned int sample){
+        int cellX = (int)((frame->left_channel[sample] + 1.00f) / cellSize);
+        int cellY = (int)((frame->right_channel[sample] + 1.00f) / cellSize);
+        cellX = (cellX < 0 ? 0 : (cellX >= gridSize ? gridSize - 1 : cellX));
+        cellY = (cellY < 0 ? 0 : (cellY >= gridSize ? gridSize - 1 : cellY));
+        return (unsigned int)(cellY * gridSize + cellX);
+    };
+
+    for(unsigned int cell = 0; cell <= cells; cell++)order_scratch.cell_start[cell] = 0;
+    for(unsigned int block = 0; block < blocks; block++){
+        const unsigned int first = frame->blocks[block].start;
+        const unsigned int last = frame->blocks[block].start + frame->blocks[block].length - 1;
+        order_scratch.ends[block * 4]     = frame->left_channel[first];
+        order_scratch.ends[block * 4 + 1] = frame->right_channel[first];
+        order_scratch.ends[block * 4 + 2] = frame->left_channel[last];
+        order_scratch.ends[block * 4 + 3] = frame->right_channel[last];
+
+        order_scratch.cell_start[cellOf(frame->blocks[block].start) + 1]++;
+        order_scratch.cell_start[cellOf(frame->blocks[block].start + frame->blocks[block].length - 1) + 1]++;
+        order_scratch.visited[block] = 0;
+        order_scratch.flipped[block] = 0;
+    }
+    for(unsigned int cell = 1; cell <= cells; cell++)order_scratch.cell_start[cell] += order_scratch.cell_start[cell - 1];
+
+    for(unsigned int cell = 0; cell < cells; cell++)order_scratch.cell_end[cell] = order_scratch.cell_start[cell]; //Filled as the items get added, it ends up equal to the next cell's start
+    for(unsigned int block = 0; block < blocks; block++){
+        order_scratch.cell_items[order_scratch.cell_end[cellOf(frame->blocks[block].start)]++] = block * 2;
+        order_scratch.cell_items[order_scratch.cell_end[cellOf(frame->blocks[block].start + frame->blocks[block].length - 1)]++] = block * 2 + 1;
+    }
+
+    //Nearest neighbour: the first primitive stays first, then the beam always goes to the closest end of what's left
+    order_scratch.order[0] = 0;
+    order_scratch.visited[0] = 1;
+    for(unsigned int i = 1; i < blocks; i++){
+        const unsigned int last = order_scratch.order[i - 1];
+        const float *exit = order_scratch.ends + last * 4 + (order_scratch.flipped[last] ? 0 : 2);
+
+        bool flip = false;
+        const unsigned int next = nearestBlock(exit[0], exit[1], &flip);
+
+        order_scratch.order[i] = next;
+        order_scratch.flipped[next] = flip;
+        order_scratch.visited[next] = 1;
+    }
+
+    //2-opt: reversing a run of the order (and flipping every block in it) whenever that makes the two jumps around the run shorter
+    //The frame loops so the last block jumps back to the first one
+    {
+        unsigned int *order = order_scratch.order;
+        unsigned char *flipped = order_scratch.flipped;
+        float *jumps = order_scratch.jumps; //jumps[i] is the distance from the block at i to the one after it
+
+        auto jumpAfter = [&](unsigned int i){
+            const unsigned int next = (i + 1) % blocks;
+            return blockDistance(order[i], flipped[order[i]], order[next], flipped[order[next]]);
+        };
+        for(unsigned int i = 0; i < blocks; i++)jumps[i] = jumpAfter(i);
+
+        for(unsigned int pass = 0; pass < ORDER_2OPT_PASSES; pass++){
+            bool improved = false;
+
+            for(unsigned int i = 0; i + 2 < blocks; i++){
+                for(unsigned int j = i + 1; j < blocks && j <= i + ORDER_2OPT_WINDOW; j++){
+                    const unsigned int after = (j + 1) % blocks;
+                    if(after == i)continue;
+
+                    const float before = jumps[i] + jumps[j];
+
+                    //Checking the first new jump on its own first, if it's already longer than both the old ones the move can't help and the second square root is skipped
+                    const float first = blockDistance(order[i], flipped[order[i]], order[j], !flipped[order[j]]);
+                    if(first >= before)continue;
+
+                    const float reversed = first + blockDistance(order[i + 1], !flipped[order[i + 1]], order[after], flipped[order[after]]);
+
+                    if(reversed < before - 1e-6f){
+                        for(unsigned int low = i + 1, high = j; low < high; low++, high--){
+                            unsigned int swap = order[low];
+                            order[low] = order[high];
+                            order[high] = swap;
+                        }
+                        for(unsigned int k = i + 1; k <= j; k++)flipped[order[k]] = !flipped[order[k]];
+                        for(unsigned int k = i; k <= j; k++)jumps[k] = jumpAfter(k);
+
+                        improved = true;
+                    }
+                }
+            }
+
+            if(!improved)break;
+        }
+    }
+
+    #if OSCLIB_TRACE_LEVEL >= OSC_TRACE_INFO
+        float totalJump = 0.00f;
+        for(unsigned int i = 0; i < blocks; i++)totalJump += order_scratch.jumps[i];
+        OSC_TRACE(OSC_TRACE_INFO, "orderFrame: blocks, total jump distance =", blocks, totalJump);
+    #endif
+
+    return osc_no_err;
+} //oscilloscopeLibrary::orderFrame
+
+osclib_err oscilloscopeLibrary::reserve(unsigned int frames, unsigned int primitives){
+    scratch.reset();
+    size_t scratch_bytes = (size_t)primitives * SCRATCH_BYTES_PER_PRIMITIVE + 8 * CACHE_LINE_SIZE; //Every array taken from the arena can waste up to a cache line
+    if(oversampling > 1)scratch_bytes += (size_t)frames * 2 * sizeof(float); //The frame at the drawing rate, before it gets interpolated
+    if(!scratch.reserve(scratch_bytes))return buffer_alloc_err;
+
+    if(scene_recording != nullptr){ //Between scene_begin() and scene_end() only the object gets reserved
+        osclib_err error_output = reserveFrame(back_frame, frames);
+        if(error_output != osc_no_err)return error_output;
+        return reserveBlocks(back_frame, primitives);
+    }
+
+    //Both frames get reserved since the back frame changes at every publish_frame()
+    //The front frame is only ever grown while it's not being played since it just gets the new memory after publish_frame() made it the back frame
+    paData *other_frame = (back_frame == &frame_swap.frames[0] ? &frame_swap.frames[1] : &frame_swap.frames[0]);
+    paData *both_frames[2] = {back_frame, other_frame};
+    for(paData *frame : both_frames){
+        if(frame == other_frame && initialised){ //Remember the request and apply it when the other frame becomes the back one
+            other_frame_reserve = frames;
+            other_frame_blocks = primitives;
+            break;
+        }
+
+        osclib_err error_output = reserveFrame(frame, frames);
+        if(error_output == osc_no_err && backFrameFree())error_output = reserveInterleaved(frame, frames * oversampling); //Otherwise interleaveFrame() grows it to the frame's capacity once the callback is done with it
+        if(error_output == osc_no_err)error_output = reserveBlocks(frame, primitives);
+        if(error_output != osc_no_err)return error_output;
+    }
+
+    return osc_no_err;
+} //oscilloscopeLibrary::reserve
+
+void oscilloscopeLibrary::clear(){
+    back_frame->buffer_frames = 0;
+    back_frame->block_count = 0;
+    transform_start = 0;
+} //oscilloscopeLibrary::clear
+
+void oscilloscopeLibrary::release(){
+    while(!backFrameFree())Pa_Sleep(1); //The callback could still be playing its interleaved samples
+    freeFrame(back_frame);
+    transform_start = 0;
+
+    scratch.release(); //The optimizer's, the sample budget's and the batches' memory goes too, it gets allocated again by the next frame that needs it
+
+    //The scene objects keep their samples, only the cache gets built again at the next publish_frame()
+    freeFrame(&scene_cache);
+    scene_dirty = true;
+} //oscilloscopeLibrary::release
+
+unsigned int oscilloscopeLibrary::frame_length(){
+    return back_frame->buffer_frames;
+} //oscilloscopeLibrary::frame_length
+
+bool oscilloscopeLibrary::backFrameFree(){
+    if(!initialised){
+        //render() runs on this thread so it can't be waited for, if it's still in the middle of the back frame it goes on with the frame published after it
+        //like it would have at the end of the back frame, the callback then starts it from its first sample
+        if(frame_swap.playing.load(std::memory_order_relaxed) == back_frame)frame_swap.playing.store(frame_swap.front.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        return true;
+    }
+
+    //Once the callback went over to the streaming ring nobody reads the frames
+    if(frame_swap.stream.load(std::memory_order_relaxed) != nullptr && frame_swap.stream_reading.load(std::memory_order_acquire) != nullptr)return true;
+
+    //The back frame is the one published before the last one, the callback lets go of it when it reaches its end and picks up the front frame
+    return frame_swap.playing.load(std::memory_order_acquire) != back_frame;
+} //oscilloscopeLibrary::backFrameFree
+
+osclib_err oscilloscopeLibrary::publish_frame(){
+    if(scene_recording != nullptr)return scene_recording_err;
+
+    while(!backFrameFree())Pa_Sleep(1); //Only happens when the last frame got published before the one playing ended, this waits at most one frame
+    return publishBackFrame();
+} //oscilloscopeLibrary::publish_frame
+
+osclib_err oscilloscopeLibrary::try_publish_frame(){
+    if(scene_recording != nullptr)return scene_recording_err;
+
+    if(!backFrameFree())return publish_busy_err;
+    return publishBackFrame();
+} //oscilloscopeLibrary::try_publish_frame
+
+osclib_err oscilloscopeLibrary::publishBackFrame(){ //Makes the back frame the front one, the callback starts playing it once it reaches the end of the frame it's playing
+    flushTransform(); //The scene gets added after this so it doesn't go through the transform
+
+    paData *published = back_frame;
+
+    //If publishing fails the scene gets taken out again, otherwise publishing the same frame again would add it a second time
+    const unsigned int drawn_frames = published->buffer_frames;
+    const unsigned int drawn_blocks = published->block_count;
+
+    osclib_err error_output = composeScene(); //The scene goes after what got drawn straight into the frame
+    if(error_output == osc_no_err)error_output = interleaveFrame(published); //Interleaving the channels here so the callback only has to copy the frame
+    if(error_output != osc_no_err){
+        published->buffer_frames = drawn_frames;
+        published->block_count = drawn_blocks;
+        return error_output;
+    }
+
+    frame_swap.front.store(published, std::memory_order_release); //Atomic pointer swap, the callback will see either the old frame or the new one and never a mix of the two
+    //Without a stream render() finishes the frame it's in and picks the new one up at its end like the callback does
+    //While the callback plays the streaming ring it goes straight to the new frame, from its first sample, once streaming stops
+    if(initialised && frame_swap.stream.load(std::memory_order_relaxed) != nullptr && frame_swap.stream_reading.load(std::memory_order_acquire) != nullptr){
+        frame_swap.playing.store(published, std::memory_order_release);
+    }
+
+    //The new back frame can still be playing, the callback only reads its interleaved samples so the channels can be drawn into straight away
+    //and backFrameFree() tells when its interleaved samples can be written again
+    back_frame = (published == &frame_swap.frames[0] ? &frame_swap.frames[1] : &frame_swap.frames[0]);
+    back_frame->buffer_frames = 0; //The new back frame still contains the frame before the published one, every frame gets drawn from scratch but its memory gets reused
+    back_frame->block_count = 0;
+    transform_start = 0;
+
+    if(other_frame_reserve > 0 || other_frame_blocks > 0){
+        //Its interleaved samples grow to the reserved size in interleaveFrame(), when the callback is done with them
+        error_output = reserveFrame(back_frame, other_frame_reserve);
+        if(error_output == osc_no_err)error_output = reserveBlocks(back_frame, other_frame_blocks);
+
+        other_frame_reserve = 0;
+        other_frame_blocks = 0;
+        if(error_output != osc_no_err)return error_output;
+    }
+
+    return osc_no_err;
+} //oscilloscopeLibrary::publishBackFrame
+
+PaError oscilloscopeLibrary::open_start(unsigned int sample_rate, unsigned long frames_per_buffer){ //Initializes portAudio (if not already), opens a new stream on the default device with the requested settings and starts the playback
+    oscStreamConfig config = stream_config();
+    config.sample_rate = sample_rate;
+    config.frames_per_buffer = frames_per_buffer;
+
+    return open_stream(config);
+} //oscilloscopeLibrary::open_start
+
+oscStreamConfig oscilloscopeLibrary::stream_config(){
+    oscStreamConfig config;
+
+    config.device = OSC_DEFAULT_DEVICE;
+    config.host_api = OSC_DEFAULT_HOST_API;
+    config.sample_rate = DEFAULT_SAMPLE_RATE;
+    config.frames_per_buffer = DEFAULT_FRAMES_PER_BUFFER;
+    config.latency = OSC_DEFAULT_LATENCY;
+
+    return config;
+} //oscilloscopeLibrary::stream_config
+
+PaError oscilloscopeLibrary::open_stream(const oscStreamConfig &config){ //Initializes portAudio (if not already), opens a new stream with the requested settings and starts the playback
     if(initialised)return paStreamIsNotStopped; //Prevent the code to run if an audio stream is already initialised and if it is return the error enumeration paStreamIsNotStopped to inform the user
 
     PaError error_output; //Stores any errors occurred during the execution of the function
 
 	const unsigned int channels = 2; //Since the oscilloscope is gonna be in XY mode, we're only using two channels
 
-    error_output = Pa_Initialize(); //Initializing portAudio storing any errors caused during the process
+    error_output = portAudio.acquire(); //Initializing portAudio if no other instance did it already
     if(error_output != paNoError) return error_output; //If any error occured return it and end the function
     //If no error occurred continue executing the program
 
-    error_output = Pa_OpenDefaultStream( //We're opening a default stream to save us the trouble of getting the default audio output device
+    //Picking the device, the one asked or the default output of the host API asked (or of the default host API)
+    PaDeviceIndex device = config.device;
+    if(device == OSC_DEFAULT_DEVICE){
+        if(config.host_api == OSC_DEFAULT_HOST_API)device = Pa_GetDefaultOutputDevice();
+        else {
+            PaHostApiIndex host_api = Pa_HostApiTypeIdToHostApiIndex((PaHostApiTypeId)config.host_api);
+            if(host_api < 0){ //The host API isn't available, the index is the error
+                portAudio.release();
+                return host_api;
+            }
+            device = Pa_GetHostApiInfo(host_api)->defaultOutputDevice;
+        }
+    }
+
+    const PaDeviceInfo *device_info = (device >= 0 && device < Pa_GetDeviceCount() ? Pa_GetDeviceInfo(device) : nullptr);
+    if(device_info == nullptr){
+        portAudio.release();
+        return paInvalidDevice;
+    }
+
+    PaStreamParameters output_parameters;
+    output_parameters.device = device;
+    output_parameters.channelCount = channels;
+    output_parameters.sampleFormat = paFloat32; //Floating 32-bit for audio output
+    output_parameters.hostApiSpecificStreamInfo = nullptr;
+
+    if(config.latency == OSC_DEFAULT_LATENCY)output_parameters.suggestedLatency = device_info->defaultHighOutputLatency;
+    else if(config.latency == OSC_LOW_LATENCY)output_parameters.suggestedLatency = device_info->defaultLowOutputLatency;
+    else output_parameters.suggestedLatency = config.latency;
+
+    error_output = Pa_OpenStream(
         &audio_stream, //Audio stream defined in the class
-        0, //In this library we're not using any input stream since we're not recording
-        channels, //Number of audio channels
-        paFloat32, //Floating 32-bit for audio output
-        sample_rate, //The playback sample rate, highering it makes the drawing of the image faster but less precise
-        preBufData.buffer_frames, //The number of frames which will be contained into the audio output buffer
+        nullptr, //In this library we're not using any input stream since we're not recording
+        &output_parameters,
+        config.sample_rate, //The playback sample rate, highering it makes the drawing of the image faster but less precise
+        config.frames_per_buffer, //The number of frames of every callback, this is the device period and it's fixed however complex the drawing gets
+        paNoFlag,
         oscilloscopeLibrary::paCallBack, //This is the callback function that portAudio will call everytime the audio is needed, we defined it in the library
-        &preBufData //All audio data that will be passed to the callback function, this struct gets filled when the draw_line() function is called
+        &frame_swap //Both frames of this instance get passed to the callback function, it plays whichever one got published last
     );
-    if(error_output != paNoError) return error_output; //Checking for errors during initialization of the audio stream
+    if(error_output != paNoError){ //Checking for errors during initialization of the audio stream
+        portAudio.release();
+        return error_output;
+    }
+
+    //The host API can round the sample rate and the latency, what it actually gave is what matters from now on
+    stream_info = Pa_GetStreamInfo(audio_stream);
+    const unsigned int granted_rate = (stream_info != nullptr && stream_info->sampleRate > 0.00 ? (unsigned int)(stream_info->sampleRate + 0.50) : config.sample_rate);
+    OSC_TRACE(OSC_TRACE_INFO, "open_stream: device, sample rate, latency (us) =", device, granted_rate, (unsigned long)(output_latency() * 1e6));
+
+    oscilloscopeLibrary::sample_rate = granted_rate; //Needed by set_refresh_rate() to know how many samples a frame gets
+    frame_swap.sample_rate = granted_rate; //And by the callback to measure the jitter
+    stream_rate.store(granted_rate, std::memory_order_relaxed); //And by the producer thread to know how fast the ring drains
+    frame_swap.health.last_dac_time = 0.00;
+
+    if(back_frame->buffer_frames > 0){ //Anything drawn before starting the stream gets played straight away
+        const osclib_err publish_error = publish_frame();
+        if(publish_error != osc_no_err){ //The stream isn't started yet, closing it is enough
+            Pa_CloseStream( oscilloscopeLibrary::audio_stream );
+            stream_info = nullptr;
+            portAudio.release();
+            return (PaError)publish_error; //osclib_err values are all positive so they can't be mistaken for a portAudio error
+        }
+    }
 
     error_output = Pa_StartStream( oscilloscopeLibrary::audio_stream ); //Starting audio playback
     if(error_output == paNoError)initialised = true; //If there were no errors then set the boolean "initialised" as true
+    else {
+        Pa_CloseStream( oscilloscopeLibrary::audio_stream );
+        stream_info = nullptr;
+        portAudio.release();
+    }
     return error_output; //Returns any error occured during Pa_StartStream, if there was no error the function will return paNoError
-} //oscilloscopeLibrary::open_start
+} //oscilloscopeLibrary::open_stream
+
+PaError oscilloscopeLibrary::list_devices(oscDeviceInfo *devices, unsigned int capacity, unsigned int *count){
+    *count = 0;
+
+    PaError error_output = portAudio.acquire(); //portAudio only knows the devices once it's initialized, the names get copied since they're gone once it's terminated
+    if(error_output != paNoError)return error_output;
+
+    const PaDeviceIndex device_count = Pa_GetDeviceCount();
+    if(device_count < 0){
+        portAudio.release();
+        return device_count;
+    }
+
+    for(PaDeviceIndex i = 0; i < device_count; i++){
+        const PaDeviceInfo *info = Pa_GetDeviceInfo(i);
+        if(info == nullptr || info->maxOutputChannels < 2)continue; //The oscilloscope needs both channels
+
+        if(devices != nullptr && *count < capacity){
+            oscDeviceInfo &device = devices[*count];
+            const PaHostApiInfo *host_api = Pa_GetHostApiInfo(info->hostApi);
+
+            device.index = i;
+            snprintf(device.name, DEVICE_NAME_LENGTH, "%s", info->name != nullptr ? info->name : "");
+            snprintf(device.host_api_name, DEVICE_NAME_LENGTH, "%s", host_api != nullptr && host_api->name != nullptr ? host_api->name : "");
+            device.host_api = (host_api != nullptr ? (int)host_api->type : OSC_DEFAULT_HOST_API);
+            device.max_output_channels = info->maxOutputChannels;
+            device.default_low_latency = info->defaultLowOutputLatency;
+            device.default_high_latency = info->defaultHighOutputLatency;
+            device.default_sample_rate = info->defaultSampleRate;
+            device.is_default = (host_api != nullptr && host_api->defaultOutputDevice == i);
+        }
+
+        (*count)++;
+    }
+
+    portAudio.release();
+    return paNoError;
+} //oscilloscopeLibrary::list_devices
+
+double oscilloscopeLibrary::output_latency(){
+    return (stream_info != nullptr ? stream_info->outputLatency : 0.00);
+} //oscilloscopeLibrary::output_latency
+
+double oscilloscopeLibrary::stream_sample_rate(){
+    return (stream_info != nullptr ? stream_info->sampleRate : 0.00);
+} //oscilloscopeLibrary::stream_sample_rate
+
+void oscilloscopeLibrary::health(oscHealth *stats){
+    const paHealth &counters = frame_swap.health;
+
+    stats->callbacks = counters.callbacks.load(std::memory_order_relaxed);
+    stats->output_underflows = counters.output_underflows.load(std::memory_order_relaxed);
+    stats->output_overflows = counters.output_overflows.load(std::memory_order_relaxed);
+    stats->priming_callbacks = counters.priming.load(std::memory_order_relaxed);
+
+    for(unsigned int i = 0; i < HEALTH_HISTOGRAM_BUCKETS; i++)stats->callback_time_histogram[i] = counters.time_histogram[i].load(std::memory_order_relaxed);
+    stats->callback_time_mean = (stats->callbacks > 0 ? counters.time_total.load(std::memory_order_relaxed) * 1e-9 / stats->callbacks : 0.00);
+    stats->callback_time_max = counters.time_max.load(std::memory_order_relaxed) * 1e-9;
+
+    const unsigned long jitterCount = counters.jitter_count.load(std::memory_order_relaxed);
+    stats->jitter_mean = (jitterCount > 0 ? counters.jitter_total.load(std::memory_order_relaxed) * 1e-9 / jitterCount : 0.00);
+    stats->jitter_max = counters.jitter_max.load(std::memory_order_relaxed) * 1e-9;
+
+    stats->stream_underruns = counters.stream_underruns.load(std::memory_order_relaxed);
+
+    stats->frames_swapped = counters.swaps.load(std::memory_order_relaxed);
+
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    const double elapsed = std::chrono::duration<double>(now - health_last_time).count();
+    stats->swaps_per_second = (elapsed > 0.00 && stats->frames_swapped >= health_last_swaps ? (stats->frames_swapped - health_last_swaps) / elapsed : 0.00);
+
+    health_last_swaps = stats->frames_swapped;
+    health_last_time = now;
+} //oscilloscopeLibrary::health
+
+void oscilloscopeLibrary::reset_health(){ //The callback could be counting at the same time, a callback running during the reset may still end up in the old counts
+    paHealth &counters = frame_swap.health;
+
+    counters.callbacks.store(0, std::memory_order_relaxed);
+    counters.output_underflows.store(0, std::memory_order_relaxed);
+    counters.output_overflows.store(0, std::memory_order_relaxed);
+    counters.priming.store(0, std::memory_order_relaxed);
+    counters.swaps.store(0, std::memory_order_relaxed);
+
+    for(unsigned int i = 0; i < HEALTH_HISTOGRAM_BUCKETS; i++)counters.time_histogram[i].store(0, std::memory_order_relaxed);
+    counters.time_total.store(0, std::memory_order_relaxed);
+    counters.time_max.store(0, std::memory_order_relaxed);
+
+    counters.jitter_count.store(0, std::memory_order_relaxed);
+    counters.jitter_total.store(0, std::memory_order_relaxed);
+    counters.jitter_max.store(0, std::memory_order_relaxed);
+
+    counters.stream_underruns.store(0, std::memory_order_relaxed);
+
+    health_last_swaps = 0;
+    health_last_time = std::chrono::steady_clock::now();
+} //oscilloscopeLibrary::reset_health
+
+oscStreamingConfig oscilloscopeLibrary::streaming_config(){
+    oscStreamingConfig config;
+
+    config.depth = STREAM_DEFAULT_DEPTH;
+    config.high_watermark = STREAM_DEFAULT_HIGH_WATERMARK;
+    config.low_watermark = STREAM_DEFAULT_LOW_WATERMARK;
+    config.block_frames = STREAM_DEFAULT_BLOCK_FRAMES;
+
+    return config;
+} //oscilloscopeLibrary::streaming_config
+
+osclib_err oscilloscopeLibrary::start_streaming(const oscStreamingConfig &config, oscStreamProducer producer, void *user_data){
+    if(frame_swap.stream.load(std::memory_order_relaxed) != nullptr)return streaming_err;
+    if(config.depth == 0 || config.block_frames == 0 || config.low_watermark >= config.high_watermark)return streaming_err;
+
+    unsigned long capacity = 1;
+    while(capacity < config.depth)capacity <<= 1;
+    if(config.high_watermark > capacity)return streaming_err;
+
+    float *samples = new(std::nothrow) float[capacity * 2];
+    if(samples == nullptr)return buffer_alloc_err;
+
+    stream_ring.samples = samples;
+    stream_ring.mask = capacity - 1;
+    stream_ring.write.store(0, std::memory_order_relaxed);
+    stream_ring.read.store(0, std::memory_order_relaxed);
+    stream_ring.hold_left = 0.00f;
+    stream_ring.hold_right = 0.00f;
+    streaming = config;
+
+    frame_swap.stream.store(&stream_ring, std::memory_order_release); //From the next callback on the ring gets played
+
+    if(producer != nullptr){
+        stream_stop.store(false, std::memory_order_relaxed);
+        try{
+            stream_producer = std::thread(&oscilloscopeLibrary::producerLoop, this, producer, user_data);
+        } catch(...){
+            stop_streaming();
+            return thread_start_err;
+        }
+    }
+
+    return osc_no_err;
+} //oscilloscopeLibrary::start_streaming
+
+osclib_err oscilloscopeLibrary::stop_streaming(){
+    if(frame_swap.stream.load(std::memory_order_relaxed) == nullptr)return streaming_err;
+
+    if(stream_producer.joinable()){
+        stream_stop.store(true, std::memory_order_relaxed);
+        stream_producer.join();
+    }
+
+    frame_swap.stream.store(nullptr, std::memory_order_release);
+
+    //The callback could still be copying out of the ring, once a callback played the frames instead it can't be anymore
+    if(initialised)while(frame_swap.stream_reading.load(std::memory_order_acquire) != nullptr)Pa_Sleep(1);
+    frame_swap.stream_reading.store(nullptr, std::memory_order_relaxed);
+
+    delete[] stream_ring.samples;
+    stream_ring.samples = nullptr;
+
+    return osc_no_err;
+} //oscilloscopeLibrary::stop_streaming
+
+unsigned long oscilloscopeLibrary::stream_write(const float *samples, unsigned long frames){
+    if(frame_swap.stream.load(std::memory_order_relaxed) == nullptr)return 0;
+
+    const unsigned long capacity = stream_ring.mask + 1;
+    const unsigned long write = stream_ring.write.load(std::memory_order_relaxed); //Only the producer moves it
+    const unsigned long space = capacity - (write - stream_ring.read.load(std::memory_order_acquire));
+    if(frames > space)frames = space;
+
+    const unsigned long start = write & stream_ring.mask;
+    const unsigned long first = (frames < capacity - start ? frames : capacity - start);
+    memcpy(stream_ring.samples + start * 2, samples, first * 2 * sizeof(float));
+    memcpy(stream_ring.samples, samples + first * 2, (frames - first) * 2 * sizeof(float));
+
+    stream_ring.write.store(write + frames, std::memory_order_release); //Only now the callback can see the new samples
+    return frames;
+} //oscilloscopeLibrary::stream_write
+
+unsigned long oscilloscopeLibrary::stream_fill(){
+    if(frame_swap.stream.load(std::memory_order_relaxed) == nullptr)return 0;
+    return stream_ring.write.load(std::memory_order_acquire) - stream_ring.read.load(std::memory_order_acquire);
+} //oscilloscopeLibrary::stream_fill
+
+void oscilloscopeLibrary::producerLoop(oscStreamProducer producer, void *user_data){ //Keeps the ring between the watermarks, the producer function writes straight into the ring
+    const unsigned long capacity = stream_ring.mask + 1;
+    bool filling = true;
+
+    while(!stream_stop.load(std::memory_order_relaxed)){
+        const unsigned long write = stream_ring.write.load(std::memory_order_relaxed);
+        const unsigned long fill = write - stream_ring.read.load(std::memory_order_acquire);
+
+        if(fill >= streaming.high_watermark)filling = false;
+        else if(fill <= streaming.low_watermark)filling = true;
+
+        if(!filling){
+            //Sleeping about as long as the callback takes to drain the ring down to the low watermark, the callback never has to wake this thread up
+            const unsigned long micros = (unsigned long)((fill - streaming.low_watermark) * 1e6 / stream_rate.load(std::memory_order_relaxed));
+            std::this_thread::sleep_for(std::chrono::microseconds(micros > 100 ? micros : 100));
+            continue;
+        }
+
+        //Asking for one block at most, and never past the end of the ring so the producer gets one contiguous piece
+        const unsigned long start = write & stream_ring.mask;
+        unsigned long frames = capacity - fill;
+        if(frames > streaming.block_frames)frames = streaming.block_frames;
+        if(frames > capacity - start)frames = capacity - start;
+
+        unsigned long produced = producer(stream_ring.samples + start * 2, frames, user_data);
+        if(produced > frames)produced = frames;
+
+        if(produced == 0){ //Nothing to play yet
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            continue;
+        }
+
+        stream_ring.write.store(write + produced, std::memory_order_release);
+    }
+} //oscilloscopeLibrary::producerLoop
 
 PaError oscilloscopeLibrary::stop_close(){ //Stops the playback of an already playing audio stream
     if(!initialised)return paStreamIsStopped; //Prevent the code to run if no audio stream is playing
 
-    delete preBufData.left_channel; //Delete the buffer since the program ended and we don't need it anymore.
-    delete preBufData.right_channel;
-
 	PaError error_output; //Stores any errors occurred during the execution of the function
 
     error_output = Pa_StopStream( oscilloscopeLibrary::audio_stream ); //Stopping the audio playback of the audio stream defined into the class
     if(error_output != paNoError) return error_output; //If any error occurred during the stopping of the playback return the error
 
+    //Delete both frames only after the stream stopped since the callback could still be reading the front one
+    frame_swap.front.store(nullptr, std::memory_order_release);
+    frame_swap.playing.store(nullptr, std::memory_order_release);
+    frame_swap.cursor = 0;
+    freeFrame(&frame_swap.frames[0]);
+    freeFrame(&frame_swap.frames[1]);
+    if(scene_recording == nullptr)transform_start = 0; //The back frame is empty now, what gets drawn next starts from its beginning
+
     //If no audio stream was playing close the stream anyway (if no stream was created in the first place then it will just return an error)
     error_output = Pa_CloseStream( oscilloscopeLibrary::audio_stream ); //Closing the audio stream
-    if(error_output == paNoError)initialised = false; //If there was no error during the stopping of the stream then set the initialised boean as false
+    if(error_output == paNoError){ //If there was no error during the stopping of the stream then set the initialised boean as false
+        initialised = false;
+        stream_info = nullptr; //portAudio frees it with the stream
+        portAudio.release(); //Terminates portAudio if this was the last open stream
+    }
     return error_output; //Returns any error occured during Pa_StartStream, if there was no error the function will return paNoError
 } //oscilloscopeLibrary::stop_close
 
-osclib_err oscilloscopeLibrary::updateBuffer(){
-    if(initialised)return audio_stream_ill_modif; //Prevent this code to run if an audio stream is playing, the buffer shouldn't be edited and resized during audio stream playback
+unsigned int oscilloscopeLibrary::lineSteps(oscPointF start, oscPointF end){ //Number of steps needed to go from start to end, density steps for every unit of length (0.01)
+    //Using the pythagorian theorem to get the length of the line
+    const float distanceX = end.x - start.x;
+    const float distanceY = end.y - start.y;
 
-    if(!buffer_initialised){ //If the buffer hasn't been defined yet define it, tell the program we defined it and end the function.
-        terminal::out::println("creating new pointer with size ", preBufData.buffer_frames);
+    return (unsigned int)std::ceil(std::sqrt(distanceX * distanceX + distanceY * distanceY) * draw_density);
+} //oscilloscopeLibrary::lineSteps
 
-        preBufData.left_channel  = new float[preBufData.buffer_frames];
-        preBufData.right_channel = new float[preBufData.buffer_frames];
+void oscilloscopeLibrary::set_density(float samples_per_unit){
+    if(samples_per_unit > 0.00f)density = samples_per_unit;
+    transformChanged();
+} //oscilloscopeLibrary::set_density
 
-        buffer_initialised = true;
+float oscilloscopeLibrary::sample_density(){
+    return density / oversampling;
+} //oscilloscopeLibrary::sample_density
 
-        return osc_no_err;
+osclib_err oscilloscopeLibrary::draw_samples(const float *left, const float *right, unsigned int frames){
+    unsigned int position;
+    osclib_err error_output = growBuffer(frames, &position);
+    if(error_output != osc_no_err)return error_output;
+
+    memcpy(back_frame->left_channel + position,  left,  frames * sizeof(float));
+    memcpy(back_frame->right_channel + position, right, frames * sizeof(float));
+
+    return osc_no_err;
+} //oscilloscopeLibrary::draw_samples
+
+void oscilloscopeLibrary::set_oversampling(unsigned int factor){
+    if(factor >= 1 && factor <= MAX_OVERSAMPLING)oversampling = factor;
+    transformChanged();
+} //oscilloscopeLibrary::set_oversampling
+
+oscTransform oscilloscopeLibrary::identity_transform(){
+    return {1.00f, 0.00f, 0.00f, 1.00f, 0.00f, 0.00f};
+} //oscilloscopeLibrary::identity_transform
+
+bool oscilloscopeLibrary::isIdentity(const oscTransform &matrix){
+    return matrix.a == 1.00f && matrix.b == 0.00f && matrix.c == 0.00f && matrix.d == 1.00f && matrix.e == 0.00f && matrix.f == 0.00f;
+} //oscilloscopeLibrary::isIdentity
+
+oscTransform oscilloscopeLibrary::multiplyTransform(const oscTransform &first, const oscTransform &second){ //The transform doing second and then first
+    oscTransform output;
+
+    output.a = first.a * second.a + first.c * second.b;
+    output.b = first.b * second.a + first.d * second.b;
+    output.c = first.a * second.c + first.c * second.d;
+    output.d = first.b * second.c + first.d * second.d;
+    output.e = first.a * second.e + first.c * second.f + first.e;
+    output.f = first.b * second.e + first.d * second.f + first.f;
+
+    return output;
+} //oscilloscopeLibrary::multiplyTransform
+
+void oscilloscopeLibrary::flushTransform(){ //Runs everything drawn with the current transform through it, this has to happen before the transform changes or the samples get used
+    if(transform_start >= back_frame->buffer_frames){ //Nothing new, or the frame got emptied without transform_start following it
+        transform_start = back_frame->buffer_frames;
+        return;
     }
 
-    terminal::out::println("executing the rest of the stuff");
+    const unsigned int frames = back_frame->buffer_frames - transform_start;
 
-    float bufferCopyLCH[preBufData.buffer_frames]; //Creating two temporary arrays to store the content of the buffer that's gonna be deleted
-    float bufferCopyRCH[preBufData.buffer_frames]; //These are respectively the copy of the left channel and the copy of the right one
+    if(frames > 0 && !isIdentity(transform)){
+        //Same conversion to the -1.00 to +1.00 scale as in spliceFrame()
+        const float sampleMatrix[6] = {transform.a, transform.b, transform.c, transform.d, transform.a + transform.c + transform.e * 0.01f - 1.00f, transform.b + transform.d + transform.f * 0.01f - 1.00f};
 
-	//Copying into the just-created arrays the contents of the buffer
-    for(unsigned int i = 0; i < buffer_size_old;i++){
-        bufferCopyLCH[i] = *(preBufData.left_channel + i);
-        bufferCopyRCH[i] = *(preBufData.right_channel + i);
+        float *left = back_frame->left_channel + transform_start;
+        float *right = back_frame->right_channel + transform_start;
+        osclib_simd::affine(left, right, left, right, frames, sampleMatrix);
     }
 
-	//Delete the buffer pointer arrays
-	delete preBufData.left_channel;
-	delete preBufData.right_channel;
+    transform_start = back_frame->buffer_frames;
+} //oscilloscopeLibrary::flushTransform
+
+void oscilloscopeLibrary::transformChanged(){
+    //Lines and curves get as many samples as their length after the transform, the zoom is the square root of how much the transform scales areas
+    float zoom = std::sqrt(std::fabs(transform.a * transform.d - transform.b * transform.c));
+    if(!(zoom > 0.00f))zoom = 1.00f; //A transform squashing everything on a line has no area, the samples are kept as they are
+
+    draw_density = density / oversampling * zoom;
+} //oscilloscopeLibrary::transformChanged
+
+osclib_err oscilloscopeLibrary::push_transform(){
+    if(transform_depth == TRANSFORM_STACK_DEPTH)return transform_stack_err;
+
+    transform_stack[transform_depth++] = transform;
+    return osc_no_err;
+} //oscilloscopeLibrary::push_transform
+
+osclib_err oscilloscopeLibrary::pop_transform(){
+    if(transform_depth == 0)return transform_stack_err;
+
+    set_transform(transform_stack[--transform_depth]);
+    return osc_no_err;
+} //oscilloscopeLibrary::pop_transform
+
+void oscilloscopeLibrary::reset_transform(){
+    set_transform(identity_transform());
+} //oscilloscopeLibrary::reset_transform
+
+void oscilloscopeLibrary::set_transform(const oscTransform &matrix){
+    flushTransform();
+
+    transform = matrix;
+    transformChanged();
+} //oscilloscopeLibrary::set_transform
+
+void oscilloscopeLibrary::apply_transform(const oscTransform &matrix){
+    set_transform(multiplyTransform(transform, matrix));
+} //oscilloscopeLibrary::apply_transform
 
-	//Create two new buffer pointer arrays and make them as big as the preBufData.buffer_frames variable specifies
-	preBufData.left_channel = new float[preBufData.buffer_frames];
-	preBufData.right_channel = new float[preBufData.buffer_frames];
+void oscilloscopeLibrary::translate(float x, float y){
+    apply_transform({1.00f, 0.00f, 0.00f, 1.00f, x, y});
+} //oscilloscopeLibrary::translate
 
-	//Copy all the data into the new buffer
-	for(unsigned int i = 0;i < preBufData.buffer_frames;i++){
-		*(preBufData.left_channel + i)  = bufferCopyLCH[i];
-		*(preBufData.right_channel + i) = bufferCopyRCH[i];
-	}
+void oscilloscopeLibrary::rotate(float degrees, float cx, float cy){
+    const float angle = degrees * M_PI / 180.00f;
+    const float cosine = std::cos(angle), sine = std::sin(angle);
 
-	//buffer_size_old is the prebuffer's size after the last resizing
-	buffer_size_old = preBufData.buffer_frames;
+    //Moving cx cy to the origin, rotating and moving it back, all in one matrix
+    apply_transform({cosine, sine, -sine, cosine, cx - cosine * cx + sine * cy, cy - sine * cx - cosine * cy});
+} //oscilloscopeLibrary::rotate
 
-	return osc_no_err; //end the function
-} //oscilloscopeLibrary::updateBuffer
+void oscilloscopeLibrary::scale(float x, float y){
+    apply_transform({x, 0.00f, 0.00f, y, 0.00f, 0.00f});
+} //oscilloscopeLibrary::scale
 
-float oscilloscopeLibrary::absolute(float input){ //This function is used only in the draw_line
-	return input >= 0.00f ? input * 1.00f : input *= -1.00f; //Take the input and make it negative if it's not already
-} //oscilloscopeLibrary::absolute
+//Writes steps samples going from start towards end into the back frame, the end itself is not written so the next line can start from it
+void oscilloscopeLibrary::rasterLine(unsigned int position, oscPointF start, oscPointF end, unsigned int steps){
+    const float startX = start.x * 0.01f - 1.00f; //The line's ends, modified to range from a scale of 0 to 200 to a scale of -1.00 to +1.00
+    const float startY = start.y * 0.01f - 1.00f;
+    const float endX = end.x * 0.01f - 1.00f;
+    const float endY = end.y * 0.01f - 1.00f;
+
+    //Every sample moves the beam by the same fixed step on both channels, so the whole line is just two ramps
+    const float stepX = (steps > 0 ? (endX - startX) / steps : 0.00f);
+    const float stepY = (steps > 0 ? (endY - startY) / steps : 0.00f);
+
+    osclib_simd::ramp(back_frame->left_channel + position,  startX, stepX, steps);
+    osclib_simd::ramp(back_frame->right_channel + position, startY, stepY, steps);
+} //oscilloscopeLibrary::rasterLine
+
+void oscilloscopeLibrary::rasterEnd(unsigned int position, oscPointF end){ //Writes the last sample of a line so it ends exactly on its last point whatever the rounding of the steps was
+    *(back_frame->left_channel + position)  = end.x * 0.01f - 1.00f;
+    *(back_frame->right_channel + position) = end.y * 0.01f - 1.00f;
+} //oscilloscopeLibrary::rasterEnd
 
 //Draws a line on the screen
 osclib_err oscilloscopeLibrary::draw_line(unsigned int x1, unsigned int y1, unsigned int x2, unsigned int y2){
-    if(initialised)return audio_stream_ill_modif; //Prevent the buffer to be modified while the audio stream is running
+    return draw_linef(x1, y1, x2, y2);
+} //oscilloscopeLibrary::draw_line
 
-	const bool FALL = false; //Used to define the direction variable
-	const bool RISE = true;  //If the direction goes up then the definition is in RISE, otherwise in FALL
+osclib_err oscilloscopeLibrary::draw_linef(float x1, float y1, float x2, float y2){
+    const oscPointF start = {x1, y1};
+    const oscPointF end = {x2, y2};
 
-	float distanceToX2 = absolute(x2 - x1); //the distance from the current value to the end value
-	float distanceToY2 = absolute(y2 - y1); //Right now it's set as the distance between the first variable and the second one to calculate how much should the buffer be incremented
+    //The line takes one sample for every step plus its last point, this is the exact number of samples it will write so it's known before drawing anything
+    const unsigned int steps = lineSteps(start, end);
 
-	signed int distanceRatio; //the ratio between distanceToX2 and distanceToY2
+    unsigned int line_start; //Position of the first sample of the line into the frame
+    osclib_err error_output = growBuffer(steps + 1, &line_start); //Grow the buffer by the calculated size
+    if(error_output != osc_no_err)return error_output;
 
- 	//Using the pythagorian theorem to calculate how long will the buffer need to be in order to draw the line
-	preBufData.buffer_frames += sqrt((double)pow((double)distanceToX2, 2) + pow((double)distanceToY2, 2)) + 1;
-	updateBuffer(); //Update the buffer to the calculated size
+    OSC_TRACE(OSC_TRACE_DEBUG, "draw_linef: line_start, line_frames =", line_start, steps + 1);
 
-	unsigned long iterator = buffer_current_position; //Iterator for the cycle that writes to the prebuffer
-	float iX = (x1 * 0.01f - 1.00f); //Iterator for the X coord
-	float iY = (y1 * 0.01f - 1.00f); //Iterator for the Y coord
+    rasterLine(line_start, start, end, steps);
+    rasterEnd(line_start + steps, end);
 
-	bool directionX = ((x2 - x1) >= 0); //The direction in which the channels have to go at (RISE = true, FALL = false)
-	bool directionY = ((y2 - y1) >= 0);
+    return osc_no_err;
+} //oscilloscopeLibrary::draw_linef
+
+//Draws count lines one after the other as a single primitive, line(i, &segment) gives the i-th line (an oscSegmentF) and returns true if its end point has to be drawn too
+//First every line's number of samples gets added up into line_offsets so the frame only grows once and every line knows where it goes,
+//then the lines get drawn, split between the worker threads if the batch is big enough
+template<typename lineOf>
+osclib_err oscilloscopeLibrary::rasterBatch(unsigned int count, lineOf line){
+    scratch.reset();
+    line_offsets = scratch.allocate<unsigned int>(count + 1);
+    if(line_offsets == nullptr)return buffer_alloc_err;
+
+    unsigned int total_frames = 0;
+    for(unsigned int i = 0; i < count; i++){
+        oscSegmentF segment;
+        bool end = line(i, &segment);
+
+        line_offsets[i] = total_frames;
+        total_frames += lineSteps(segment.start, segment.end) + end;
+    }
+    line_offsets[count] = total_frames;
+
+    unsigned int position;
+    osclib_err error_output = growBuffer(total_frames, &position);
+    if(error_output != osc_no_err)return error_output;
+
+    struct batchContext {
+        oscilloscopeLibrary *library;
+        lineOf *line;
+        unsigned int position;
+        unsigned int count;
+        unsigned int chunks;
+
+        //Draws the lines from first to last, their number of samples is already in line_offsets so lineSteps() isn't needed again
+        void drawLines(unsigned int first, unsigned int last){
+            for(unsigned int i = first; i < last; i++){
+                oscSegmentF segment;
+                bool end = (*line)(i, &segment);
+
+                const unsigned int start = position + library->line_offsets[i];
+                const unsigned int steps = library->line_offsets[i + 1] - library->line_offsets[i] - end;
+
+                library->rasterLine(start, segment.start, segment.end, steps);
+                if(end)library->rasterEnd(start + steps, segment.end);
+            }
+        }
+    } context = {this, &line, position, count, 1};
 
-    terminal::out::println("buffer_frames = ", preBufData.buffer_frames);
-    terminal::out::println("buffer_current_position = ", buffer_current_position);
-    terminal::out::println("directionX = ", directionX, " - directionY = ", directionY, ENDLINE, ENDLINE);
+    if(workerPool.threads() <= 1 || total_frames < PARALLEL_MIN_SAMPLES){
+        context.drawLines(0, count);
+        return osc_no_err;
+    }
 
-    *(preBufData.left_channel + iterator)  = x1 * 0.01f - 1.00f; //Setting the first value of the buffer to the initial variables, modified to range from a scale of 0 to 200 to a scale of -1.00 to +1.00
-    *(preBufData.right_channel + iterator) = y1 * 0.01f - 1.00f; //Not doing this results in the entire buffer being empty since every value of the buffer is dependant on the last one
+    //Every chunk gets the same number of samples and not the same number of lines, so a few long lines don't end up in the same chunk as lots of short ones
+    //A chunk draws the lines starting inside its range of samples, they're found with a binary search into line_offsets
+    context.chunks = workerPool.threads() * PARALLEL_CHUNKS_PER_THREAD;
+    bool parallel = workerPool.run([](void *data, unsigned int chunk){
+        batchContext *batch = (batchContext*)data;
+        const unsigned int *offsets = batch->library->line_offsets;
+        const unsigned long long total = offsets[batch->count];
 
-    do{
-        //Recalculate both distances every loop
-		distanceToX2 = absolute(x2 - (iX + 1.00f) * 100);
-		distanceToY2 = absolute(y2 - (iY + 1.00f) * 100);
+        const unsigned int from = (unsigned int)(total * chunk / batch->chunks);
+        const unsigned int to = (unsigned int)(total * (chunk + 1) / batch->chunks);
 
-        //Recalculate the distanceRatio every loop
-        //This is the ratio between the distance from the biggest variable to the end and the smallest variable to the end rounded down
-		distanceRatio = distanceToX2 > distanceToY2 ? (int)(distanceToX2 / distanceToY2) : (int)(distanceToY2 / distanceToX2);
+        const unsigned int first = std::lower_bound(offsets, offsets + batch->count, from) - offsets;
+        const unsigned int last = std::lower_bound(offsets, offsets + batch->count, to) - offsets;
+        batch->drawLines(first, last);
+    }, &context, context.chunks);
 
-        terminal::out::println("distanceToX2 = ", distanceToX2, " - distanceToY2 = ", distanceToY2, " - distanceRatio = ", distanceRatio);
+    if(!parallel)context.drawLines(0, count); //Another instance was using the pool
 
-		if(distanceToX2 > distanceToY2){
-			*(preBufData.left_channel + iterator)  = *(preBufData.left_channel + iterator - 1)  + ((directionX==RISE ? 1.00f : -1.00f) * (distanceRatio / 100.00f));
-			*(preBufData.right_channel + iterator) = *(preBufData.right_channel + iterator - 1) + ((directionY==RISE ? 1.00f : -1.00f) * 0.01f);
-		} else if(distanceToX2 < distanceToY2){
-			*(preBufData.left_channel + iterator)  = *(preBufData.left_channel + iterator - 1)  + ((directionX==RISE ? 1.00f : -1.00f) * 0.01f);
-			*(preBufData.right_channel + iterator) = *(preBufData.right_channel + iterator - 1) + ((directionY==RISE ? 1.00f : -1.00f) * (distanceRatio / 100.00f));
-		} else if(distanceToX2 == distanceToY2){
-			*(preBufData.left_channel + iterator)  = *(preBufData.left_channel + iterator - 1)  + ((directionX==RISE ? 1.00f : -1.00f) * 0.01f);
-			*(preBufData.right_channel + iterator) = *(preBufData.right_channel + iterator - 1) + ((directionY==RISE ? 1.00f : -1.00f) * 0.01f);
-		}
+    OSC_TRACE(OSC_TRACE_DEBUG, "rasterBatch: lines, samples, chunks =", count, total_frames, context.chunks);
 
-        terminal::out::println("writing to buffer in position ", iterator, " - left_channel = ", *(preBufData.left_channel + iterator), " - right_channel = ", *(preBufData.right_channel + iterator));
+    return osc_no_err;
+} //oscilloscopeLibrary::rasterBatch
 
-        iX = *(preBufData.left_channel + iterator);
-        iY = *(preBufData.right_channel + iterator);
+osclib_err oscilloscopeLibrary::set_threads(unsigned int threads){
+    if(threads == 0)threads = std::thread::hardware_concurrency();
+    if(threads == 0)threads = 1; //hardware_concurrency() returns 0 if it doesn't know
 
-        terminal::out::println("iX = ", iX, " - iY = ", iY);
-        terminal::out::println("iterator = ", iterator);
-        terminal::out::println(ENDLINE);
+    if(threads == workerPool.threads())return osc_no_err;
+    return (workerPool.start(threads) ? osc_no_err : thread_start_err);
+} //oscilloscopeLibrary::set_threads
 
-		iterator++;
-	} while(distanceToX2 != 0 && distanceToY2 != 0);
+unsigned int oscilloscopeLibrary::thread_count(){
+    return workerPool.threads();
+} //oscilloscopeLibrary::thread_count
 
-    buffer_current_position = iterator;
+osclib_err oscilloscopeLibrary::draw_polyline(const oscPoint *points, unsigned int count){
+    if(count == 0)return osc_no_err;
+    if(count == 1){ //A single point, drawn as a line with no length
+        oscSegment point = {points[0], points[0]};
+        return draw_segments(&point, 1);
+    }
 
-    return osc_no_err;
-} //oscilloscopeLibrary::draw_line
+    //Every vertex is shared between two lines so only the last point gets drawn as an end point
+    return rasterBatch(count - 1, [points, count](unsigned int i, oscSegmentF *segment){
+        segment->start = {(float)points[i].x, (float)points[i].y};
+        segment->end = {(float)points[i + 1].x, (float)points[i + 1].y};
+        return (i + 2 == count);
+    });
+} //oscilloscopeLibrary::draw_polyline
+
+osclib_err oscilloscopeLibrary::draw_polygon(const oscPoint *points, unsigned int count){
+    if(count == 0)return osc_no_err;
+
+    //Same as draw_polyline() with one more line going from the last point back to the first one
+    return rasterBatch(count, [points, count](unsigned int i, oscSegmentF *segment){
+        segment->start = {(float)points[i].x, (float)points[i].y};
+        segment->end = {(float)points[(i + 1) % count].x, (float)points[(i + 1) % count].y};
+        return (i + 1 == count);
+    });
+} //oscilloscopeLibrary::draw_polygon
+
+osclib_err oscilloscopeLibrary::draw_segments(const oscSegment *segments, unsigned int count){
+    if(count == 0)return osc_no_err;
+
+    //A segment only needs its last point drawn if the next segment doesn't start from there
+    return rasterBatch(count, [segments, count](unsigned int i, oscSegmentF *segment){
+        segment->start = {(float)segments[i].start.x, (float)segments[i].start.y};
+        segment->end = {(float)segments[i].end.x, (float)segments[i].end.y};
+
+        bool continued = (i + 1 < count && segments[i + 1].start.x == segments[i].end.x && segments[i + 1].start.y == segments[i].end.y);
+        return !continued;
+    });
+} //oscilloscopeLibrary::draw_segments
+
+osclib_err oscilloscopeLibrary::draw_polylinef(const oscPointF *points, unsigned int count, bool closed){
+    if(count == 0)return osc_no_err;
+    if(count == 1)return draw_linef(points[0].x, points[0].y, points[0].x, points[0].y); //A single point, drawn as a line with no length
+
+    const unsigned int lines = (closed ? count : count - 1);
+    return rasterBatch(lines, [points, count, lines](unsigned int i, oscSegmentF *segment){
+        segment->start = points[i];
+        segment->end = points[(i + 1) % count];
+        return (i + 1 == lines);
+    });
+} //oscilloscopeLibrary::draw_polylinef
 
 //Draws a dot for the screen and keeps the vectorscope on that dot for a certain duration
 osclib_err oscilloscopeLibrary::draw_point(unsigned int x, unsigned int y, unsigned short duration){
-    if(initialised)return audio_stream_ill_modif; //Prevent the buffer to be modified while the audio stream is running
+    return draw_pointf(x, y, duration);
+} //oscilloscopeLibrary::draw_point
 
-    preBufData.buffer_frames += duration; //The duration is the amount of time the vectorscope should be staying on the defined coordinates, that defines the brightness of the dot and the speed at which it will be shown during drawing
-    oscilloscopeLibrary::updateBuffer();
+osclib_err oscilloscopeLibrary::draw_pointf(float x, float y, unsigned short duration){
+    //The duration is the amount of time the vectorscope should be staying on the defined coordinates, that defines the brightness of the dot and the speed at which it will be shown during drawing
+    duration = (unsigned short)((duration + oversampling - 1) / oversampling); //Every drawn sample lasts oversampling samples of the stream
 
-    *(preBufData.left_channel + buffer_current_position)  = x * 0.01f - 1.00f; //setting the first value of the buffer to the specified x and y coordinate
-    *(preBufData.right_channel + buffer_current_position) = y * 0.01f - 1.00f; //Not doing this results in the buffer being empty since every value written depends on the last one
+    unsigned int point_start; //Position of the first sample of the point into the frame
+    osclib_err error_output = growBuffer(duration, &point_start);
+    if(error_output != osc_no_err)return error_output;
 
-    buffer_current_position++; //Incrementing the position of the buffer by one to not override the just filled in values during the loop
+    const float pointX = x * 0.01f - 1.00f; //The point's coordinates, modified to range from a scale of 0 to 200 to a scale of -1.00 to +1.00
+    const float pointY = y * 0.01f - 1.00f;
 
-    for(unsigned short i = buffer_current_position;i < duration + buffer_current_position;i++){
-        *(preBufData.left_channel + i)  = *(preBufData.left_channel + i - 1);
-        *(preBufData.right_channel + i) = *(preBufData.right_channel + i - 1);
+    for(unsigned int i = point_start;i < point_start + duration;i++){
+        *(back_frame->left_channel + i)  = pointX;
+        *(back_frame->right_channel + i) = pointY;
     }
 
     return osc_no_err;
-} //oscilloscopeLibrary::draw_point
+} //oscilloscopeLibrary::draw_pointf
+
+//Rasterizes the strokes of a glyph at GLYPH_SAMPLES_PER_UNIT and returns how many samples it took
+//If x and y are null nothing is written, this is used to size the cache before filling it
+unsigned int oscilloscopeLibrary::compileGlyph(const char *strokes, float *x, float *y){
+    unsigned int samples = 0;
+
+    while(*strokes != '\0'){
+        if(*strokes == ' '){
+            strokes++;
+            continue;
+        }
+
+        float lastX = strokes[0] - '0';
+        float lastY = strokes[1] - '0';
+        strokes += 2;
+
+        while(*strokes >= '0' && *strokes <= '9'){ //Every vertex after the first one ends a line of the stroke
+            float vertexX = strokes[0] - '0';
+            float vertexY = strokes[1] - '0';
+            strokes += 2;
+
+            const float distanceX = vertexX - lastX;
+            const float distanceY = vertexY - lastY;
+            const unsigned int steps = (unsigned int)std::ceil(std::sqrt(distanceX * distanceX + distanceY * distanceY) * GLYPH_SAMPLES_PER_UNIT);
+
+            if(x != nullptr){
+                osclib_simd::ramp(x + samples, lastX, distanceX / steps, steps);
+                osclib_simd::ramp(y + samples, lastY, distanceY / steps, steps);
+            }
+            samples += steps;
+
+            lastX = vertexX;
+            lastY = vertexY;
+        }
+
+        if(x != nullptr){ //The last vertex of the stroke, the beam then jumps straight to the next stroke
+            x[samples] = lastX;
+            y[samples] = lastY;
+        }
+        samples++;
+    }
+
+    return samples;
+} //oscilloscopeLibrary::compileGlyph
+
+osclib_err oscilloscopeLibrary::compileFont(){ //Rasterizes the whole font into fontCache, this only happens the first time text gets drawn
+    if(fontCache.compiled.load(std::memory_order_acquire))return osc_no_err;
+
+    std::lock_guard<std::mutex> lock(fontCache.lock);
+    if(fontCache.compiled.load(std::memory_order_relaxed))return osc_no_err; //Another thread compiled it while this one was waiting
+
+    unsigned int total = 0;
+    for(unsigned int i = 0; i < OSCFONT_GLYPHS; i++){
+        fontCache.start[i] = total;
+        fontCache.length[i] = compileGlyph(osclib_font::glyphs[i], nullptr, nullptr);
+        total += fontCache.length[i];
+    }
+
+    fontCache.x = new (std::nothrow) float[total];
+    fontCache.y = new (std::nothrow) float[total];
+    if(fontCache.x == nullptr || fontCache.y == nullptr){
+        delete[] fontCache.x;
+        delete[] fontCache.y;
+        fontCache.x = nullptr;
+        fontCache.y = nullptr;
+        return buffer_alloc_err;
+    }
+
+    for(unsigned int i = 0; i < OSCFONT_GLYPHS; i++)compileGlyph(osclib_font::glyphs[i], fontCache.x + fontCache.start[i], fontCache.y + fontCache.start[i]);
+
+    fontCache.compiled.store(true, std::memory_order_release);
+    return osc_no_err;
+} //oscilloscopeLibrary::compileFont
+
+osclib_err oscilloscopeLibrary::draw_text(unsigned int x, unsigned int y, const char *text, float scale){
+    osclib_err error_output = compileFont();
+    if(error_output != osc_no_err)return error_output;
+
+    //Adding up the samples of every character so the frame only grows once
+    unsigned int total_frames = 0;
+    for(const char *character = text; *character != '\0'; character++){
+        if(*character != '\n')total_frames += (fontCache.length[osclib_font::glyphIndex(*character)] + oversampling - 1) / oversampling;
+    }
+
+    unsigned int position;
+    error_output = growBuffer(total_frames, &position);
+    if(error_output != osc_no_err)return error_output;
+
+    //Every character is just its cached samples scaled and moved to where the character goes, modified to range from a scale of 0 to 200 to a scale of -1.00 to +1.00
+    const float sampleScale = scale * 0.01f;
+    unsigned int column = 0;
+    unsigned int row = 0;
+
+    for(const char *character = text; *character != '\0'; character++){
+        if(*character == '\n'){
+            column = 0;
+            row++;
+            continue;
+        }
+
+        const unsigned int glyph = osclib_font::glyphIndex(*character);
+        const float offsetX = (x + column * GLYPH_ADVANCE * scale) * 0.01f - 1.00f;
+        const float offsetY = ((float)y - row * GLYPH_LINE_HEIGHT * scale) * 0.01f - 1.00f;
+
+        if(oversampling == 1){
+            osclib_simd::scaleOffset(fontCache.x + fontCache.start[glyph], back_frame->left_channel + position,  sampleScale, offsetX, fontCache.length[glyph]);
+            osclib_simd::scaleOffset(fontCache.y + fontCache.start[glyph], back_frame->right_channel + position, sampleScale, offsetY, fontCache.length[glyph]);
+
+            position += fontCache.length[glyph];
+        } else { //Only every oversampling-th sample of the glyph, publish_frame() fills the ones in between back in
+            for(unsigned int i = 0; i < fontCache.length[glyph]; i += oversampling, position++){
+                back_frame->left_channel[position]  = fontCache.x[fontCache.start[glyph] + i] * sampleScale + offsetX;
+                back_frame->right_channel[position] = fontCache.y[fontCache.start[glyph] + i] * sampleScale + offsetY;
+            }
+        }
+        column++;
+    }
+
+    return osc_no_err;
+} //oscilloscopeLibrary::draw_text
+
+unsigned int oscilloscopeLibrary::curveSteps(float length){ //Number of steps for a curve of the given length on the screen
+    unsigned int steps = (unsigned int)std::ceil(length * draw_density);
+    return (steps < MIN_CURVE_STEPS ? MIN_CURVE_STEPS : steps);
+} //oscilloscopeLibrary::curveSteps
+
+//Draws the part of an ellipse going from start_angle for sweep radians, every angle of the ellipse is rotated by rotation radians around the center
+//The points are generated by rotating a unit vector by the same small angle at every sample, so there's only one sine and cosine for the whole curve
+osclib_err oscilloscopeLibrary::rasterEllipse(float cx, float cy, float rx, float ry, float rotation, float start_angle, float sweep, float length){
+    const unsigned int steps = curveSteps(length);
+
+    unsigned int position;
+    osclib_err error_output = growBuffer(steps + 1, &position);
+    if(error_output != osc_no_err)return error_output;
+
+    //The step rotation, doubles so the error of the repeated rotations stays far below a unit even for the biggest curves
+    const double stepCos = std::cos((double)sweep / steps);
+    const double stepSin = std::sin((double)sweep / steps);
+
+    //The rotation of the whole ellipse combined with its radii, this maps a point of the unit circle onto the ellipse
+    const float axisXX = rx * std::cos(rotation), axisXY = rx * std::sin(rotation);
+    const float axisYX = -ry * std::sin(rotation), axisYY = ry * std::cos(rotation);
+
+    //Modified to range from a scale of 0 to 200 to a scale of -1.00 to +1.00
+    const float centerX = cx * 0.01f - 1.00f;
+    const float centerY = cy * 0.01f - 1.00f;
+
+    double unitX = std::cos((double)start_angle);
+    double unitY = std::sin((double)start_angle);
+
+    float *left = back_frame->left_channel + position;
+    float *right = back_frame->right_channel + position;
+
+    for(unsigned int i = 0; i <= steps; i++){
+        if(i == steps){ //Making sure the curve ends exactly on its last point however much the rotations drifted
+            unitX = std::cos((double)start_angle + sweep);
+            unitY = std::sin((double)start_angle + sweep);
+        }
+
+        left[i]  = centerX + (float)(unitX * axisXX + unitY * axisYX) * 0.01f;
+        right[i] = centerY + (float)(unitX * axisXY + unitY * axisYY) * 0.01f;
+
+        const double nextX = unitX * stepCos - unitY * stepSin;
+        unitY = unitX * stepSin + unitY * stepCos;
+        unitX = nextX;
+    }
+
+    return osc_no_err;
+} //oscilloscopeLibrary::rasterEllipse
+
+osclib_err oscilloscopeLibrary::draw_circle(unsigned int cx, unsigned int cy, unsigned int radius){
+    return rasterEllipse(cx, cy, radius, radius, 0.00f, 0.00f, 2.00f * M_PI, 2.00f * M_PI * radius);
+} //oscilloscopeLibrary::draw_circle
+
+osclib_err oscilloscopeLibrary::draw_arc(unsigned int cx, unsigned int cy, unsigned int radius, float start_angle, float end_angle){
+    const float start = start_angle * M_PI / 180.00f;
+    const float sweep = (end_angle - start_angle) * M_PI / 180.00f; //Negative sweeps go clockwise
+
+    return rasterEllipse(cx, cy, radius, radius, 0.00f, start, sweep, std::fabs(sweep) * radius);
+} //oscilloscopeLibrary::draw_arc
+
+osclib_err oscilloscopeLibrary::draw_ellipse(unsigned int cx, unsigned int cy, unsigned int rx, unsigned int ry, float rotation){
+    return draw_ellipsef(cx, cy, rx, ry, rotation);
+} //oscilloscopeLibrary::draw_ellipse
+
+osclib_err oscilloscopeLibrary::draw_ellipsef(float cx, float cy, float rx, float ry, float rotation){
+    //Ramanujan's approximation of the perimeter, close enough to pick the number of samples
+    const float a = rx, b = ry;
+    const float length = M_PI * (3.00f * (a + b) - std::sqrt((3.00f * a + b) * (a + 3.00f * b)));
+
+    return rasterEllipse(cx, cy, rx, ry, rotation * M_PI / 180.00f, 0.00f, 2.00f * M_PI, length);
+} //oscilloscopeLibrary::draw_ellipsef
+
+//The points are generated with forward differencing: after the first point every sample is just three additions per channel
+osclib_err oscilloscopeLibrary::draw_bezier(oscPoint p0, oscPoint p1, oscPoint p2, oscPoint p3){
+    return draw_bezierf({(float)p0.x, (float)p0.y}, {(float)p1.x, (float)p1.y}, {(float)p2.x, (float)p2.y}, {(float)p3.x, (float)p3.y});
+} //oscilloscopeLibrary::draw_bezier
+
+osclib_err oscilloscopeLibrary::draw_bezierf(oscPointF p0, oscPointF p1, oscPointF p2, oscPointF p3){
+    //The length is estimated as the average of the chord and of the control polygon, the real length is always between the two
+    const float chord = std::hypot(p3.x - p0.x, p3.y - p0.y);
+    const float polygon = std::hypot(p1.x - p0.x, p1.y - p0.y) + std::hypot(p2.x - p1.x, p2.y - p1.y) + std::hypot(p3.x - p2.x, p3.y - p2.y);
+    const unsigned int steps = curveSteps((chord + polygon) / 2.00f);
+
+    unsigned int position;
+    osclib_err error_output = growBuffer(steps + 1, &position);
+    if(error_output != osc_no_err)return error_output;
+
+    //Polynomial coefficients of the curve, B(t) = a t^3 + b t^2 + c t + p0, already on the -1.00 to +1.00 scale
+    const double h = 1.00 / steps;
+    const double startX = p0.x * 0.01 - 1.00, startY = p0.y * 0.01 - 1.00;
+    const double cX = 3.00 * ((double)p1.x - p0.x) * 0.01, cY = 3.00 * ((double)p1.y - p0.y) * 0.01;
+    const double bX = 3.00 * ((double)p2.x - 2.00 * p1.x + p0.x) * 0.01, bY = 3.00 * ((double)p2.y - 2.00 * p1.y + p0.y) * 0.01;
+    const double aX = ((double)p3.x - 3.00 * p2.x + 3.00 * p1.x - p0.x) * 0.01, aY = ((double)p3.y - 3.00 * p2.y + 3.00 * p1.y - p0.y) * 0.01;
+
+    //First, second and third forward differences of the polynomial for a step of h
+    double pointX = startX, pointY = startY;
+    double firstX = aX * h * h * h + bX * h * h + cX * h, firstY = aY * h * h * h + bY * h * h + cY * h;
+    double secondX = 6.00 * aX * h * h * h + 2.00 * bX * h * h, secondY = 6.00 * aY * h * h * h + 2.00 * bY * h * h;
+    const double thirdX = 6.00 * aX * h * h * h, thirdY = 6.00 * aY * h * h * h;
+
+    float *left = back_frame->left_channel + position;
+    float *right = back_frame->right_channel + position;
+
+    for(unsigned int i = 0; i < steps; i++){
+        left[i]  = (float)pointX;
+        right[i] = (float)pointY;
+
+        pointX += firstX;
+        pointY += firstY;
+        firstX += secondX;
+        firstY += secondY;
+        secondX += thirdX;
+        secondY += thirdY;
+    }
+
+    rasterEnd(position + steps, p3); //Ending exactly on p3
+
+    return osc_no_err;
+} //oscilloscopeLibrary::draw_bezierf
+
+osclib_err oscilloscopeLibrary::render(float *output, unsigned long frames){
+    if(initialised)return audio_stream_ill_modif; //The callback's cursor belongs to the audio stream while it's running
+
+    //Calling the callback exactly like portAudio would, there's just no time info since there's no device
+    oscilloscopeLibrary::paCallBack(nullptr, output, frames, nullptr, 0, &frame_swap);
+
+    return osc_no_err;
+} //oscilloscopeLibrary::render
+
+bool oscilloscopeLibrary::writeFile(int file, const void *data, size_t bytes){ //Writes all the bytes to the file, write() is allowed to only write some of them
+    const char *remaining = (const char*)data;
+
+    while(bytes > 0){
+        ssize_t written = write(file, remaining, bytes);
+        if(written <= 0)return false;
+
+        remaining += written;
+        bytes -= written;
+    }
+
+    return true;
+} //oscilloscopeLibrary::writeFile
+
+osclib_err oscilloscopeLibrary::render_to_file(const char *name, unsigned long frames, unsigned int sample_rate, osclib_file_format format){
+    if(initialised)return audio_stream_ill_modif;
+
+    if(sample_rate != oscilloscopeLibrary::sample_rate){
+        //The budget of a refresh rate is a number of samples so it depends on the rate of the output, like open_start() does with the stream's rate
+        oscilloscopeLibrary::sample_rate = sample_rate;
+        frame_swap.sample_rate = sample_rate;
+        stream_rate.store(sample_rate, std::memory_order_relaxed);
+
+        //Without a stream nobody plays the published frame, its channels are still there so it can be interleaved again for the new rate
+        paData *published = frame_swap.front.load(std::memory_order_relaxed);
+        if(refresh_rate >= MIN_REFRESH_RATE && published != nullptr && published->buffer_frames > 0){
+            osclib_err error_output = interleaveFrame(published);
+            if(error_output != osc_no_err)return error_output;
+        }
+    }
+
+    int file = open(name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(file < 0)return file_write_err;
+
+    if(format == osc_file_wav){
+        //WAV header for 2 channels of 32-bit floats (format 3, IEEE float), every field is little endian
+        const unsigned int data_bytes = frames * 2 * (unsigned int)sizeof(float);
+        const unsigned int fields[] = {
+            0x46464952,            //"RIFF"
+            36 + data_bytes,       //Size of everything after this field
+            0x45564157,            //"WAVE"
+            0x20746d66,            //"fmt "
+            16,                    //Size of the fmt chunk
+            3 | (2 << 16),         //Format (IEEE float) and number of channels
+            sample_rate,
+            sample_rate * 2 * (unsigned int)sizeof(float), //Bytes per second
+            (2 * (unsigned int)sizeof(float)) | (32 << 16), //Bytes per frame and bits per sample
+            0x61746164,            //"data"
+            data_bytes
+        };
+
+        unsigned char header[sizeof(fields)];
+        for(unsigned int i = 0; i < sizeof(fields) / sizeof(fields[0]); i++){
+            header[i * 4]     = fields[i] & 0xff;
+            header[i * 4 + 1] = (fields[i] >> 8) & 0xff;
+            header[i * 4 + 2] = (fields[i] >> 16) & 0xff;
+            header[i * 4 + 3] = (fields[i] >> 24) & 0xff;
+        }
+
+        if(!writeFile(file, header, sizeof(header))){
+            close(file);
+            return file_write_err;
+        }
+    }
+
+    //Rendering one block at a time so the memory used doesn't depend on how long the output is
+    float block[RENDER_BLOCK_FRAMES * 2];
+    while(frames > 0){
+        unsigned long block_frames = (frames < RENDER_BLOCK_FRAMES ? frames : RENDER_BLOCK_FRAMES);
+
+        render(block, block_frames);
+        if(!writeFile(file, block, block_frames * 2 * sizeof(float))){
+            close(file);
+            return file_write_err;
+        }
+
+        frames -= block_frames;
+    }
+
+    if(close(file) != 0)return file_write_err;
+    return osc_no_err;
+} //oscilloscopeLibrary::render_to_file
 
 #endif
\ No newline at end of file
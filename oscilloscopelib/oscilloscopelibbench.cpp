@@ -0,0 +1,274 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+//Benchmarks for the drawing, buffering, callback and terminal paths
+//Usage: ./oscilloscopelibbench [output file] (defaults to bench_results.csv)
+//Every result is a CSV line: benchmark,case,iterations,ns_per_op,ns_per_sample,allocs_per_op
+//allocs_per_op counts everything allocated with new and new[] plus the library's cache line aligned allocations
+
+#define MIN_BENCH_TIME (0.2) //Every case keeps running until it took at least this many seconds
+
+//Counting every allocation made through new so every benchmark can report how many allocations an operation does
+static std::atomic<unsigned long> allocations{0};
+
+//The interleaved frames and the scratch arena don't go through new, the library lets them be counted through its allocation hook
+static void *countedAlignedAlloc(size_t alignment, size_t bytes){
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::aligned_alloc(alignment, bytes);
+}
+#define OSCLIB_ALIGNED_ALLOC(alignment, bytes) countedAlignedAlloc((alignment), (bytes))
+
+#include "oscilloscopelib.hpp"
+#include "oscilloscopeSvg.hpp"
+
+void *operator new(size_t size){
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void *memory = std::malloc(size ? size : 1);
+    if(memory == nullptr)throw std::bad_alloc();
+    return memory;
+}
+void *operator new[](size_t size){return operator new(size);}
+void *operator new(size_t size, const std::nothrow_t&) noexcept{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+void *operator new[](size_t size, const std::nothrow_t&) noexcept{return operator new(size, std::nothrow);}
+void operator delete(void *memory) noexcept{std::free(memory);}
+void operator delete[](void *memory) noexcept{std::free(memory);}
+void operator delete(void *memory, size_t) noexcept{std::free(memory);}
+void operator delete[](void *memory, size_t) noexcept{std::free(memory);}
+
+oscilloscopeLibrary oscilloscope;
+FILE *results;
+
+//Runs operation until MIN_BENCH_TIME has passed and writes its results, operation returns the number of samples it produced
+template <typename function>
+void bench(const char *benchmark, const char *name, function operation){
+    using clock = std::chrono::steady_clock;
+
+    operation(); //Warm-up run so the first growth of the buffers doesn't end up in the results
+
+    unsigned long iterations = 0;
+    unsigned long samples = 0;
+    unsigned long allocations_start = allocations.load();
+
+    clock::time_point start = clock::now();
+    double elapsed;
+    do{
+        samples += operation();
+        iterations++;
+        elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    } while(elapsed < MIN_BENCH_TIME);
+
+    double ns_per_op = elapsed * 1e9 / iterations;
+    double ns_per_sample = (samples > 0 ? elapsed * 1e9 / samples : 0.00);
+    double allocs_per_op = (double)(allocations.load() - allocations_start) / iterations;
+
+    fprintf(results, "%s,%s,%lu,%.3f,%.4f,%.3f\n", benchmark, name, iterations, ns_per_op, ns_per_sample, allocs_per_op);
+    fprintf(stderr, "%-14s %-24s %12.1f ns/op %10.4f ns/sample %8.3f allocs/op\n", benchmark, name, ns_per_op, ns_per_sample, allocs_per_op);
+}
+
+int main(int argc, char *argv[]){
+    const char *output_name = (argc > 1 ? argv[1] : "bench_results.csv");
+    results = fopen(output_name, "w");
+    if(results == nullptr){
+        fprintf(stderr, "cannot open %s\n", output_name);
+        return 1;
+    }
+    fprintf(results, "benchmark,case,iterations,ns_per_op,ns_per_sample,allocs_per_op\n");
+
+    //Everything the library and the terminal functions print goes to /dev/null, the results are written to the file and to stderr
+    int devnull = open("/dev/null", O_WRONLY);
+    dup2(devnull, STDOUT_FILENO);
+
+    //draw_line across lengths and slopes, 100 lines per operation into a cleared frame
+    struct { const char *name; unsigned int x1, y1, x2, y2; } lines[] = {
+        {"len1_horizontal",    100, 100, 101, 100},
+        {"len10_horizontal",   100, 100, 110, 100},
+        {"len200_horizontal",    0, 100, 200, 100},
+        {"len200_vertical",    100,   0, 100, 200},
+        {"len283_diagonal",      0,   0, 200, 200},
+        {"len200_steep",        20,   0,  40, 199},
+        {"len200_reversed",    200, 200,   0, 150},
+    };
+    for(auto &line : lines){
+        bench("draw_line", line.name, [&]{
+            oscilloscope.clear();
+            for(int i = 0; i < 100; i++)oscilloscope.draw_line(line.x1, line.y1, line.x2, line.y2);
+            return (unsigned long)oscilloscope.frame_length();
+        });
+    }
+
+    //draw_point with large durations
+    unsigned short durations[] = {100, 5000, 60000};
+    for(unsigned short duration : durations){
+        char name[32];
+        snprintf(name, sizeof(name), "duration%u", duration);
+        bench("draw_point", name, [&]{
+            oscilloscope.clear();
+            oscilloscope.draw_point(50, 150, duration);
+            return (unsigned long)duration;
+        });
+    }
+
+    //Growth of the frame from empty, the memory is given back before every operation so every operation grows the frame from scratch
+    unsigned int growths[] = {1000, 10000, 100000};
+    for(unsigned int points : growths){
+        char name[32];
+        snprintf(name, sizeof(name), "points%u", points);
+        bench("buffer_growth", name, [&]{
+            oscilloscope.release();
+            for(unsigned int i = 0; i < points; i++)oscilloscope.draw_point(i % 200, 100, 1);
+            return (unsigned long)points;
+        });
+    }
+
+    //Drawing and publishing short lines scattered over the screen, with and without the draw order optimizer
+    unsigned int primitives[] = {100, 1000, 5000};
+    for(int optimized = 0; optimized < 2; optimized++){
+        oscilloscope.set_optimize_order(optimized);
+
+        for(unsigned int count : primitives){
+            char name[32];
+            snprintf(name, sizeof(name), "lines%u_%s", count, optimized ? "ordered" : "unordered");
+
+            bench("optimize_order", name, [&]{
+                srand(1);
+                for(unsigned int i = 0; i < count; i++){
+                    unsigned int x = rand() % 190, y = rand() % 190;
+                    oscilloscope.draw_line(x, y, x + rand() % 10, y + rand() % 10);
+                }
+                unsigned long samples = oscilloscope.frame_length();
+                oscilloscope.publish_frame();
+                return samples;
+            });
+        }
+    }
+    oscilloscope.set_optimize_order(false);
+
+    //A big polyline drawn on the caller's thread and then split over one thread per core
+    static oscPoint drawing[20000];
+    srand(3);
+    for(oscPoint &point : drawing)point = {(unsigned int)(rand() % 201), (unsigned int)(rand() % 201)};
+    unsigned int thread_counts[] = {1, 0};
+    for(unsigned int threads : thread_counts){
+        oscilloscope.set_threads(threads);
+        if(threads == 0 && oscilloscope.thread_count() == 1)continue; //One core, it would be the same case as the one before
+
+        //The one thread per core case is labelled with the threads it really got, and _auto so it's never the same key as a fixed count
+        char name[48];
+        snprintf(name, sizeof(name), (threads == 0 ? "polyline20000_threads%u_auto" : "polyline20000_threads%u"), oscilloscope.thread_count());
+        bench("parallel_raster", name, [&]{
+            oscilloscope.clear();
+            oscilloscope.draw_polyline(drawing, 20000);
+            return (unsigned long)oscilloscope.frame_length();
+        });
+    }
+    oscilloscope.set_threads(1);
+
+    //A retained scene of 300 small objects with only 3 of them drawn again before every publish, against drawing all 300 every frame
+    unsigned int objects[300];
+    for(unsigned int i = 0; i < 300; i++){
+        oscilloscope.scene_add(&objects[i]);
+        oscilloscope.scene_begin(objects[i]);
+        oscilloscope.draw_circle(10 + (i % 20) * 9, 10 + (i / 20) * 12, 4);
+        oscilloscope.scene_end();
+    }
+    unsigned int changed = 0;
+    bench("scene", "retained_3_of_300", [&]{
+        for(int i = 0; i < 3; i++, changed++){
+            unsigned int object = changed % 300;
+            oscilloscope.scene_begin(objects[object]);
+            oscilloscope.draw_circle(10 + (object % 20) * 9, 10 + (object / 20) * 12, 3 + changed % 2);
+            oscilloscope.scene_end();
+        }
+        oscilloscope.publish_frame();
+        return 0UL;
+    });
+    for(unsigned int i = 0; i < 300; i++)oscilloscope.scene_show(objects[i], false);
+    bench("scene", "immediate_300", [&]{
+        for(unsigned int i = 0; i < 300; i++)oscilloscope.draw_circle(10 + (i % 20) * 9, 10 + (i / 20) * 12, 4);
+        oscilloscope.publish_frame();
+        return 0UL;
+    });
+    for(unsigned int i = 0; i < 300; i++)oscilloscope.scene_remove(objects[i]);
+
+    //The same lines drawn at the sample rate and at a quarter of it with publish_frame() interpolating them back up
+    unsigned int factors[] = {1, 4};
+    for(unsigned int factor : factors){
+        oscilloscope.set_oversampling(factor);
+
+        char name[32];
+        snprintf(name, sizeof(name), "lines1000_x%u", factor);
+        bench("oversampling", name, [&]{
+            for(int i = 0; i < 1000; i++)oscilloscope.draw_line(i % 200, 0, (i * 7) % 200, 200);
+            oscilloscope.publish_frame();
+            return 0UL;
+        });
+    }
+    oscilloscope.set_oversampling(1);
+
+    //Loading a generated SVG of 2000 paths by parsing it every time, against reading back its cached samples
+    const char *svg_name = "/tmp/oscilloscopelibbench.svg";
+    FILE *svg = fopen(svg_name, "w");
+    if(svg != nullptr){
+        srand(5);
+        fprintf(svg, "<svg xmlns=\"http://www.w3.org/2000/svg\" viewBox=\"0 0 1000 1000\">\n");
+        for(int i = 0; i < 2000; i++){
+            fprintf(svg, "<path d=\"M%d %d c%d %d %d %d %d %d l%d %d q5 5 10 0 a5 5 0 0 1 10 0z\" transform=\"rotate(%d 500 500)\"/>\n",
+                    rand() % 900, rand() % 900, rand() % 50, rand() % 50, rand() % 50, rand() % 50, rand() % 50, rand() % 50, rand() % 50, rand() % 50, rand() % 360);
+        }
+        fprintf(svg, "</svg>\n");
+        fclose(svg);
+
+        const char *cache_paths[] = {nullptr, SVG_CACHE_NEXT_TO_FILE};
+        const char *svg_cases[] = {"paths2000_parsed", "paths2000_cached"};
+        for(int cached = 0; cached < 2; cached++){
+            bench("svg_load", svg_cases[cached], [&]{
+                unsigned int id;
+                osclib_svg::load(oscilloscope, svg_name, &id, cache_paths[cached]);
+                const float *left, *right;
+                const paBlock *blocks;
+                unsigned int frames = 0, block_count;
+                oscilloscope.scene_samples(id, &left, &right, &frames, &blocks, &block_count);
+                oscilloscope.scene_remove(id);
+                return (unsigned long)frames;
+            });
+        }
+
+        unlink(svg_name);
+        unlink("/tmp/oscilloscopelibbench.svg.osccache");
+    }
+
+    //The callback driven headlessly through render(), over a ~10k sample frame at a few device periods
+    oscilloscope.clear();
+    for(int i = 0; i < 50; i++)oscilloscope.draw_line(0, i * 4, 200, 200 - i * 4);
+    oscilloscope.publish_frame();
+
+    unsigned long periods[] = {64, 128, 1024};
+    static float callback_output[1024 * 2];
+    for(unsigned long period : periods){
+        char name[32];
+        snprintf(name, sizeof(name), "period%lu", period);
+        bench("callback", name, [&]{
+            for(int i = 0; i < 100; i++)oscilloscope.render(callback_output, period);
+            return period * 100;
+        });
+    }
+
+    //terminal::out::println with numeric arguments
+    bench("println", "integers", []{
+        terminal::out::println("x = ", 12345, " y = ", 678);
+        return 0UL;
+    });
+    bench("println", "floats", []{
+        terminal::out::println("x = ", -0.734512f, " y = ", 0.250000f);
+        return 0UL;
+    });
+
+    fclose(results);
+    fprintf(stderr, "results written to %s\n", output_name);
+    return 0;
+}
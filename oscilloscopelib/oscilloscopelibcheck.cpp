@@ -0,0 +1,457 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+
+//Counting the allocations like the benchmarks do, the arena check needs the ones made through new and through the library's allocation hook
+static std::atomic<unsigned long> allocations{0};
+
+static void *countedAlignedAlloc(size_t alignment, size_t bytes){
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::aligned_alloc(alignment, bytes);
+}
+#define OSCLIB_ALIGNED_ALLOC(alignment, bytes) countedAlignedAlloc((alignment), (bytes))
+
+#include "oscilloscopelib.hpp"
+#include "oscilloscopeSvg.hpp"
+
+void *operator new(size_t size){
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void *memory = std::malloc(size ? size : 1);
+    if(memory == nullptr)throw std::bad_alloc();
+    return memory;
+}
+void *operator new[](size_t size){return operator new(size);}
+void *operator new(size_t size, const std::nothrow_t&) noexcept{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+void *operator new[](size_t size, const std::nothrow_t&) noexcept{return operator new(size, std::nothrow);}
+void operator delete(void *memory) noexcept{std::free(memory);}
+void operator delete[](void *memory) noexcept{std::free(memory);}
+void operator delete(void *memory, size_t) noexcept{std::free(memory);}
+void operator delete[](void *memory, size_t) noexcept{std::free(memory);}
+
+//Headless self-check of what the library promises, everything goes through render(), render_to_file() and scene_samples() so no audio device is needed
+//Usage: ./oscilloscopelibcheck, it prints every check and returns 1 if any of them failed
+//The files it writes (a raw render, an SVG and its cache) are created in the working directory and deleted at the end
+
+#define CHECK_TOLERANCE (1e-5f) //Largest difference allowed between two samples that went through different float math
+
+static int failures = 0;
+
+//Prints the failure and carries on with the other checks
+#define CHECK(condition, ...) do{ \
+    if(!(condition)){ \
+        failures++; \
+        fprintf(stderr, "  FAIL line %d: ", __LINE__); \
+        fprintf(stderr, __VA_ARGS__); \
+        fprintf(stderr, "\n"); \
+    } \
+}while(0)
+
+//True if samples (pairs long) repeat every period pairs
+static bool periodic(const float *samples, unsigned long pairs, unsigned long period){
+    for(unsigned long i = 0; i + period < pairs; i++){
+        if(samples[i * 2] != samples[(i + period) * 2] || samples[i * 2 + 1] != samples[(i + period) * 2 + 1])return false;
+    }
+    return true;
+}
+
+static bool sameSamples(oscilloscopeLibrary &first_library, unsigned int first, oscilloscopeLibrary &second_library, unsigned int second){ //Bit for bit, blocks included
+    const float *left[2], *right[2];
+    const paBlock *blocks[2];
+    unsigned int frames[2], block_count[2];
+    if(first_library.scene_samples(first, &left[0], &right[0], &frames[0], &blocks[0], &block_count[0]) != osc_no_err)return false;
+    if(second_library.scene_samples(second, &left[1], &right[1], &frames[1], &blocks[1], &block_count[1]) != osc_no_err)return false;
+
+    if(frames[0] != frames[1] || block_count[0] != block_count[1])return false;
+    if(memcmp(left[0], left[1], frames[0] * sizeof(float)) != 0 || memcmp(right[0], right[1], frames[0] * sizeof(float)) != 0)return false;
+    for(unsigned int i = 0; i < block_count[0]; i++){
+        if(blocks[0][i].start != blocks[1][i].start || blocks[0][i].length != blocks[1][i].length)return false;
+    }
+    return true;
+}
+
+//render() keeps its place in the frame between calls and wraps around to its start, whatever the size of the calls
+static void checkRenderWrap(){
+    oscilloscopeLibrary oscilloscope;
+
+    const unsigned int frames = 1000;
+    static float left[frames], right[frames];
+    srand(1);
+    for(unsigned int i = 0; i < frames; i++){
+        left[i] = rand() / (float)RAND_MAX * 2.00f - 1.00f;
+        right[i] = rand() / (float)RAND_MAX * 2.00f - 1.00f;
+    }
+    oscilloscope.draw_samples(left, right, frames);
+    CHECK(oscilloscope.publish_frame() == osc_no_err, "publish_frame() failed");
+
+    static float output[4000 * 2];
+    const unsigned long calls[] = {7, 64, 333, 1000, 2596}; //4000 pairs, four times the frame
+    unsigned long position = 0;
+    for(unsigned long call : calls){
+        CHECK(oscilloscope.render(output + position * 2, call) == osc_no_err, "render() failed");
+        position += call;
+    }
+
+    unsigned long wrong = 0;
+    for(unsigned long i = 0; i < position; i++){
+        if(output[i * 2] != left[i % frames] || output[i * 2 + 1] != right[i % frames])wrong++;
+    }
+    CHECK(wrong == 0, "%lu of %lu rendered pairs aren't the published frame played in a loop", wrong, position);
+}
+
+//Fills a frame's worth of samples, different for every seed so frames can be told apart
+static void randomSamples(float *left, float *right, unsigned int frames, unsigned int seed){
+    srand(seed);
+    for(unsigned int i = 0; i < frames; i++){
+        left[i] = rand() / (float)RAND_MAX * 2.00f - 1.00f;
+        right[i] = rand() / (float)RAND_MAX * 2.00f - 1.00f;
+    }
+}
+
+//Counts the pairs of output that aren't left/right from first on, count pairs long
+static unsigned long differences(const float *output, const float *left, const float *right, unsigned int first, unsigned long count){
+    unsigned long wrong = 0;
+    for(unsigned long i = 0; i < count; i++){
+        if(output[i * 2] != left[first + i] || output[i * 2 + 1] != right[first + i])wrong++;
+    }
+    return wrong;
+}
+
+//A frame published in the middle of a render() starts from its first sample once the frame being rendered is over, like with the stream
+static void checkRepublish(){
+    oscilloscopeLibrary oscilloscope;
+
+    static float left_a[1000], right_a[1000], left_b[2000], right_b[2000], left_c[300], right_c[300];
+    randomSamples(left_a, right_a, 1000, 4);
+    randomSamples(left_b, right_b, 2000, 5);
+    randomSamples(left_c, right_c, 300, 6);
+
+    static float output[2000 * 2];
+    oscilloscope.draw_samples(left_a, right_a, 1000);
+    oscilloscope.publish_frame();
+    oscilloscope.render(output, 500);
+
+    oscilloscope.draw_samples(left_b, right_b, 2000);
+    oscilloscope.publish_frame();
+    oscilloscope.render(output, 600);
+    CHECK(differences(output, left_a, right_a, 500, 500) == 0, "the frame being rendered didn't get finished after a new one got published");
+    CHECK(differences(output + 500 * 2, left_b, right_b, 0, 100) == 0, "the new frame didn't start from its first sample");
+
+    //Publishing twice before render() reaches the end of the frame: the second publish reuses the frame being rendered, so render() moves on to the first one straight away
+    oscilloscope.draw_samples(left_c, right_c, 300);
+    oscilloscope.publish_frame();
+    oscilloscope.draw_samples(left_a, right_a, 1000);
+    oscilloscope.publish_frame();
+    oscilloscope.render(output, 400);
+    CHECK(differences(output, left_c, right_c, 0, 300) == 0 && differences(output + 300 * 2, left_a, right_a, 0, 100) == 0, "frames published twice in a row didn't play from their start");
+}
+
+//Publishing while the streaming ring plays, the new frame plays from its first sample after the frame that was playing once streaming stops
+static void checkStreamRepublish(){
+    oscilloscopeLibrary oscilloscope;
+
+    static float left_a[1000], right_a[1000], left_b[700], right_b[700];
+    randomSamples(left_a, right_a, 1000, 7);
+    randomSamples(left_b, right_b, 700, 8);
+
+    static float output[1200 * 2];
+    oscilloscope.draw_samples(left_a, right_a, 1000);
+    oscilloscope.publish_frame();
+    oscilloscope.render(output, 300);
+
+    oscStreamingConfig config = oscilloscopeLibrary::streaming_config();
+    CHECK(oscilloscope.start_streaming(config) == osc_no_err, "start_streaming() failed");
+
+    static float streamed[256 * 2];
+    for(unsigned int i = 0; i < 256 * 2; i++)streamed[i] = (float)i / (256 * 2);
+    CHECK(oscilloscope.stream_write(streamed, 256) == 256, "stream_write() didn't take the samples");
+    oscilloscope.render(output, 256);
+    CHECK(memcmp(output, streamed, sizeof(streamed)) == 0, "the ring didn't get played");
+
+    oscilloscope.draw_samples(left_b, right_b, 700);
+    oscilloscope.publish_frame();
+    CHECK(oscilloscope.stop_streaming() == osc_no_err, "stop_streaming() failed");
+
+    oscilloscope.render(output, 1200);
+    CHECK(differences(output, left_a, right_a, 300, 700) == 0, "the frame playing before streaming didn't carry on where it was");
+    CHECK(differences(output + 700 * 2, left_b, right_b, 0, 500) == 0, "the frame published while streaming didn't start from its first sample");
+}
+
+//With a refresh rate every frame is exactly sample rate / refresh rate samples long, for the default rate and for the one given to render_to_file()
+static void checkBudget(){
+    oscilloscopeLibrary oscilloscope;
+    oscilloscope.set_refresh_rate(60.00f);
+
+    for(unsigned int i = 0; i < 6; i++)oscilloscope.draw_line(0, i * 40, 200, 200 - i * 40);
+    CHECK(oscilloscope.publish_frame() == osc_no_err, "publish_frame() failed");
+
+    static float output[735 * 4 * 2];
+    oscilloscope.render(output, 735 * 4);
+    CHECK(periodic(output, 735 * 4, 735) && !periodic(output, 735 * 4, 734), "a 60 Hz frame at %u Hz isn't 735 samples long", DEFAULT_SAMPLE_RATE);
+
+    const char *name = "oscilloscopelibcheck.raw";
+    const unsigned long pairs = 2666 * 3;
+    CHECK(oscilloscope.render_to_file(name, pairs, 160000, osc_file_raw) == osc_no_err, "render_to_file() failed");
+
+    static float rendered[2666 * 3 * 2];
+    FILE *file = fopen(name, "rb");
+    const bool read = (file != nullptr && fread(rendered, sizeof(float) * 2, pairs, file) == pairs);
+    if(file != nullptr)fclose(file);
+    unlink(name);
+
+    CHECK(read, "couldn't read %s back", name);
+    if(read)CHECK(periodic(rendered, pairs, 2666) && !periodic(rendered, pairs, 2665), "a 60 Hz frame rendered at 160000 Hz isn't 2666 samples long");
+}
+
+//Oversampled frames go through every drawn sample and move in a straight line to the next one, wrapping around to the first
+static void checkOversampling(){
+    const unsigned int frames = 301;
+    static float left[frames], right[frames];
+    srand(2);
+    for(unsigned int i = 0; i < frames; i++){
+        left[i] = rand() / (float)RAND_MAX * 2.00f - 1.00f;
+        right[i] = rand() / (float)RAND_MAX * 2.00f - 1.00f;
+    }
+
+    const unsigned int factors[] = {1, 2, 3, 4, 8, 16}; //3 goes through the generic kernel
+    for(unsigned int factor : factors){
+        oscilloscopeLibrary oscilloscope;
+        oscilloscope.set_oversampling(factor);
+        oscilloscope.draw_samples(left, right, frames);
+        CHECK(oscilloscope.publish_frame() == osc_no_err, "publish_frame() failed at x%u", factor);
+
+        static float output[frames * MAX_OVERSAMPLING * 2];
+        oscilloscope.render(output, frames * factor);
+
+        float worst = 0.00f;
+        bool exact = true;
+        for(unsigned int i = 0; i < frames; i++){
+            const unsigned int next = (i + 1) % frames;
+            for(unsigned int j = 0; j < factor; j++){
+                const float *pair = output + (i * factor + j) * 2;
+                const float x = left[i] + (left[next] - left[i]) * j / factor;
+                const float y = right[i] + (right[next] - right[i]) * j / factor;
+
+                worst = std::max(worst, std::max(std::fabs(pair[0] - x), std::fabs(pair[1] - y)));
+                if(j == 0 && (pair[0] != left[i] || pair[1] != right[i]))exact = false;
+            }
+        }
+        CHECK(exact, "x%u doesn't play the drawn samples unchanged", factor);
+        CHECK(worst <= CHECK_TOLERANCE, "x%u is %g away from the line between two drawn samples", factor, worst);
+    }
+}
+
+//Once reserve() and a few frames warmed up the frames and the scratch arena, drawing, publishing and playing frames of the same size don't allocate anything
+static void checkArena(){
+    oscilloscopeLibrary oscilloscope;
+    oscilloscope.set_optimize_order(true); //Both take their scratch memory from the arena
+    oscilloscope.set_refresh_rate(60.00f);
+    CHECK(oscilloscope.reserve(8192, 256) == osc_no_err, "reserve() failed");
+
+    static oscSegment segments[64];
+    static float output[735 * 2];
+    unsigned long warm = 0;
+    for(unsigned int frame = 0; frame < 24; frame++){
+        if(frame == 4)warm = allocations.load(); //Both frames went through a publish by then
+
+        srand(frame % 3); //Frames of different content but the same sizes
+        for(oscSegment &segment : segments)segment = {{(unsigned int)(rand() % 201), (unsigned int)(rand() % 201)}, {(unsigned int)(rand() % 201), (unsigned int)(rand() % 201)}};
+        oscilloscope.draw_segments(segments, 64);
+        for(unsigned int i = 0; i < 32; i++)oscilloscope.draw_line(i * 6, 0, 200 - i * 6, 200);
+        oscilloscope.draw_circle(100, 100, 50 + frame % 3 * 10);
+
+        CHECK(oscilloscope.publish_frame() == osc_no_err, "publish_frame() failed on frame %u", frame);
+        oscilloscope.render(output, 735);
+    }
+    const unsigned long made = allocations.load() - warm;
+    CHECK(made == 0, "%lu allocations in 20 frames after the warm-up", made);
+}
+
+//Drawing a batch over several threads gives the same samples as drawing it on the caller's thread
+static void checkParallelRaster(){
+    static oscPoint points[20000];
+    srand(3);
+    for(oscPoint &point : points)point = {(unsigned int)(rand() % 201), (unsigned int)(rand() % 201)};
+
+    oscilloscopeLibrary serial, parallel;
+    unsigned int serial_id, parallel_id;
+
+    serial.set_threads(1);
+    serial.scene_add(&serial_id);
+    serial.scene_begin(serial_id);
+    serial.draw_polyline(points, 20000);
+    serial.scene_end();
+
+    CHECK(parallel.set_threads(4) == osc_no_err, "set_threads(4) failed");
+    parallel.scene_add(&parallel_id);
+    parallel.scene_begin(parallel_id);
+    parallel.draw_polyline(points, 20000);
+    parallel.scene_end();
+    parallel.set_threads(1);
+
+    CHECK(sameSamples(serial, serial_id, parallel, parallel_id), "a polyline drawn over 4 threads differs from the one drawn on 1");
+}
+
+//Loading an SVG from its cache gives exactly what parsing it gave
+static void checkSvgCache(){
+    const char *name = "oscilloscopelibcheck.svg";
+    const char *cache = "oscilloscopelibcheck.svg.osccache";
+
+    FILE *file = fopen(name, "w");
+    CHECK(file != nullptr, "couldn't write %s", name);
+    if(file == nullptr)return;
+    fprintf(file, "<svg xmlns=\"http://www.w3.org/2000/svg\" viewBox=\"0 0 100 50\">\n"
+                  "<g transform=\"translate(10,5) scale(0.5)\"><rect x=\"0\" y=\"0\" width=\"20\" height=\"10\"/></g>\n"
+                  "<path d=\"M10,10 h20 v20 h-20z M50 10 c10 0 10 10 20 10 s10 10 20 0 Q95 40 80 45 T60 45 a10 5 30 1 0 -10 0\" transform=\"rotate(5 50 25)\"/>\n"
+                  "<line x1=\"0\" y1=\"0\" x2=\"100\" y2=\"50\"/><circle cx=\"50\" cy=\"25\" r=\"10\"/><polygon points=\"80 0 90 10 100 0\"/>\n"
+                  "</svg>\n");
+    fclose(file);
+    unlink(cache);
+
+    oscilloscopeLibrary oscilloscope;
+    unsigned int parsed, cached;
+    CHECK(osclib_svg::load(oscilloscope, name, &parsed, cache) == osc_no_err, "parsing %s failed", name);
+    CHECK(access(cache, F_OK) == 0, "no cache got written");
+    CHECK(osclib_svg::load(oscilloscope, name, &cached, cache) == osc_no_err, "loading %s from its cache failed", name);
+    CHECK(sameSamples(oscilloscope, parsed, oscilloscope, cached), "the cached samples differ from the parsed ones");
+
+    unlink(name);
+    unlink(cache);
+}
+
+//The transform applied by the drawing functions and the one applied to scene objects
+static void checkTransform(){
+    //Rotating a horizontal line by 90 degrees around the center of the screen gives the vertical one
+    oscilloscopeLibrary rotated, straight;
+    unsigned int rotated_id, straight_id;
+
+    rotated.scene_add(&rotated_id);
+    rotated.scene_begin(rotated_id);
+    rotated.push_transform();
+    rotated.rotate(90.00f, 100.00f, 100.00f);
+    rotated.draw_linef(50.00f, 100.00f, 150.00f, 100.00f);
+    rotated.pop_transform();
+    rotated.draw_linef(20.00f, 20.00f, 40.00f, 20.00f); //After pop_transform() nothing is rotated anymore
+    rotated.scene_end();
+
+    straight.scene_add(&straight_id);
+    straight.scene_begin(straight_id);
+    straight.draw_linef(100.00f, 50.00f, 100.00f, 150.00f);
+    straight.draw_linef(20.00f, 20.00f, 40.00f, 20.00f);
+    straight.scene_end();
+
+    const float *left[2], *right[2];
+    const paBlock *blocks[2];
+    unsigned int frames[2], block_count[2];
+    if(rotated.scene_samples(rotated_id, &left[0], &right[0], &frames[0], &blocks[0], &block_count[0]) != osc_no_err ||
+       straight.scene_samples(straight_id, &left[1], &right[1], &frames[1], &blocks[1], &block_count[1]) != osc_no_err){
+        CHECK(false, "scene_samples() failed");
+        return;
+    }
+
+    CHECK(frames[0] == frames[1], "the rotated drawing has %u samples instead of %u", frames[0], frames[1]);
+    float worst = 0.00f;
+    for(unsigned int i = 0; frames[0] == frames[1] && i < frames[0]; i++){
+        worst = std::max(worst, std::max(std::fabs(left[0][i] - left[1][i]), std::fabs(right[0][i] - right[1][i])));
+    }
+    CHECK(worst <= CHECK_TOLERANCE, "the rotated line is %g away from the vertical one", worst);
+
+    //A transformed scene object is played as its samples through the matrix, odd lengths included so the vector kernels' tails get used
+    oscilloscopeLibrary oscilloscope;
+    unsigned int id;
+    oscilloscope.scene_add(&id);
+    oscilloscope.scene_begin(id);
+    oscilloscope.draw_linef(10.00f, 30.00f, 187.30f, 151.70f);
+    oscilloscope.draw_ellipsef(90.00f, 110.00f, 33.00f, 21.00f);
+    oscilloscope.scene_end();
+
+    const oscTransform matrix = {0.80f, 0.35f, -0.25f, 0.90f, 12.00f, -7.50f};
+    oscilloscope.scene_transform(id, matrix);
+    CHECK(oscilloscope.publish_frame() == osc_no_err, "publish_frame() failed");
+
+    const float *object_left, *object_right;
+    const paBlock *object_blocks;
+    unsigned int object_frames, object_block_count;
+    if(oscilloscope.scene_samples(id, &object_left, &object_right, &object_frames, &object_blocks, &object_block_count) != osc_no_err){
+        CHECK(false, "scene_samples() failed");
+        return;
+    }
+
+    float *output = new float[object_frames * 2];
+    oscilloscope.render(output, object_frames);
+
+    //The matrix is in the 0 to 200 units, on the -1.00 to +1.00 samples only the translation changes
+    const float e = matrix.a + matrix.c + matrix.e * 0.01f - 1.00f;
+    const float f = matrix.b + matrix.d + matrix.f * 0.01f - 1.00f;
+    worst = 0.00f;
+    for(unsigned int i = 0; i < object_frames; i++){
+        const float x = matrix.a * object_left[i] + matrix.c * object_right[i] + e;
+        const float y = matrix.b * object_left[i] + matrix.d * object_right[i] + f;
+        worst = std::max(worst, std::max(std::fabs(output[i * 2] - x), std::fabs(output[i * 2 + 1] - y)));
+    }
+    delete[] output;
+    CHECK(worst <= CHECK_TOLERANCE, "the transformed object is %g away from its samples through the matrix", worst);
+}
+
+//stop_close() empties both frames, what gets drawn after it under the same transform has to go through it once and start from the beginning of the frame
+//This one needs a stream to stop, it's skipped if there's no audio device
+static void checkTransformAfterStop(){
+    oscilloscopeLibrary oscilloscope;
+    if(oscilloscope.open_start() != paNoError){
+        fprintf(stderr, "  skipped, no audio stream could be opened\n");
+        return;
+    }
+
+    oscilloscope.draw_line(0, 0, 200, 200);
+    oscilloscope.rotate(30.00f, 100.00f, 100.00f);
+    for(unsigned int i = 0; i < 20; i++)oscilloscope.draw_line(0, i * 10, 200, 200 - i * 10);
+    CHECK(oscilloscope.stop_close() == paNoError, "stop_close() failed");
+
+    oscilloscope.draw_line(10, 10, 20, 10);
+    CHECK(oscilloscope.publish_frame() == osc_no_err, "publish_frame() after stop_close() failed");
+
+    //The same short line drawn by an instance that never had a stream
+    oscilloscopeLibrary expected;
+    expected.rotate(30.00f, 100.00f, 100.00f);
+    expected.draw_line(10, 10, 20, 10);
+    const unsigned int frames = expected.frame_length();
+    expected.publish_frame();
+
+    float *output = new float[(frames + 1) * 2];
+    float *wanted = new float[(frames + 1) * 2];
+    oscilloscope.render(output, frames + 1); //One more so a frame longer than the line shows up as a difference
+    expected.render(wanted, frames + 1);
+    CHECK(memcmp(output, wanted, (frames + 1) * 2 * sizeof(float)) == 0, "the line drawn after stop_close() isn't the rotated line on its own");
+    delete[] output;
+    delete[] wanted;
+}
+
+int main(){
+    //Everything the library prints goes to /dev/null, the results go to stderr
+    int devnull = open("/dev/null", O_WRONLY);
+    dup2(devnull, STDOUT_FILENO);
+
+    struct { const char *name; void (*check)(); } checks[] = {
+        {"render_wrap",      checkRenderWrap},
+        {"republish",        checkRepublish},
+        {"stream_republish", checkStreamRepublish},
+        {"budget",           checkBudget},
+        {"oversampling",     checkOversampling},
+        {"arena",            checkArena},
+        {"parallel_raster",  checkParallelRaster},
+        {"svg_cache",        checkSvgCache},
+        {"transform",        checkTransform},
+        {"transform_stop",   checkTransformAfterStop},
+    };
+
+    for(auto &check : checks){
+        const int failures_before = failures;
+        check.check();
+        fprintf(stderr, "%-16s %s\n", check.name, failures == failures_before ? "ok" : "FAILED");
+    }
+
+    fprintf(stderr, "%d check%s failed\n", failures, failures == 1 ? "" : "s");
+    return (failures == 0 ? 0 : 1);
+}